@@ -0,0 +1,800 @@
+/*----------------------------------------------------Cipher Benchmark Suite ⏱️ ----------------------------------------------------*/
+/* Author      : Hassan (a.k.a. The Eagle 🦅)
+ * Description : Micro and macro benchmarks for every cipher in the lab, written as JSON for regression tracking:
+ *               - AES-128/192/256 key expansion
+ *               - AES single-block encrypt/decrypt on each round engine
+ *               - AES bulk ECB/CTR/GCM from 16 B to 64 MiB
+ *               - Random bytes: thread-local AES-256 CTR_DRBG vs a fresh std::random_device per draw
+ *               - Many-tenant AES: per-request key expansion vs schedules leased from the KeyRegistry (hot set, churn)
+ *               - Feistel encrypt/decrypt by round count: word engine vs bitset adapter vs the original bit loop
+ *               - Feistel<BlockBits, 16, RoundFn> with the XOR, ARX and SPN round functions (64- and 16-bit halves)
+ *               - Feistel-128 bulk CBC (PKCS#7) and CTR over byte buffers from 16 B to 64 MiB
+ *               - RSA keygen latency (p50/p90/p99/max) and encrypt/CRT decrypt by modulus size, 512-4096 bits
+ *               - RSA-OAEP and PKCS#1 v1.5 encrypt/decrypt of full blocks (message bytes per second)
+ *               - Batch RSA signature verification (AVX2 four-lane and scalar), ops/sec and ops/sec per core
+ *               - RSA-PSS sign / verify / batch verify, and verification with a fresh versus a cached public key
+ *               - Modular exponentiation without the CRT at 1024-4096 bits
+ *               - X25519 and FFDH (RFC 3526, 2048-4096) key generation, comb vs generic, and handshakes/sec
+ *               - SHA-256/512 one message (SHA-NI or portable) and many small objects (multi-buffer lanes)
+ *
+ * Method      : Each case is warmed up once, then timed in batches of at least --min-ms milliseconds.
+ *               Every result is the median over --reps batches (the fastest batch is reported too).
+ *               Cycles come from the TSC (reference cycles, not core cycles), so turbo and frequency
+ *               scaling show up in ns but not in cycles. Inputs and keys come from a fixed seed;
+ *               RSA keygen is the exception, because its primes come from the OS-seeded CTR_DRBG.
+ *
+ * Build       : g++ -std=c++17 -O2 -pthread Benchmark.cpp -o Benchmark
+ * Usage       : ./Benchmark [--quick] [--only aes|feistel|rsa|kex|sha] [--engine auto|bytewise|ttable|aesni|bitsliced]
+ *                           [--threads N] [--reps N] [--min-ms N] [--max-size BYTES] [-o results.json]
+ *               Progress goes to stderr and the JSON to stdout (or -o). AES_FORCE_PORTABLE=1 turns off AES-NI/AVX2/PCLMUL,
+ *               BN_FORCE_PORTABLE=1 the AVX2 big-number lanes, SHA_FORCE_PORTABLE=1 SHA-NI and the AVX2 hash lanes.
+ *
+ * License     : Public Domain / MIT — use it, break it, improve it 👨‍💻
+ */
+
+#include "../Symmetric Key Cryptography/AES.hpp"
+#include "../Hashing Algorithms/SHA512.hpp"
+#include "../Public Key Cryptogrphy/KeyExchange.hpp"
+#include "../Public Key Cryptogrphy/RSA.hpp"
+#include "../Symmetric Key Cryptography/FeistelCipher.hpp"
+
+#include <fstream>
+#include <memory>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+using std::cout;
+using std::endl;
+
+/*----------------------------------------------------Timing Harness----------------------------------------------------*/
+// Steady clock for ns, TSC for cycles. Each measured closure writes its output somewhere the sink can see,
+// so the optimizer cannot drop the work.
+namespace bench {
+
+struct Options {
+   int reps = 7;
+   double minMs = 20;
+   size_t maxSize = 64 << 20;
+   size_t threads = 1; // 1 = reproducible single-core numbers; raise it to see the pool scale
+   aes::Engine engine = aes::Engine::Auto;
+   std::string only, outPath;
+   bool quick = false;
+};
+
+struct Result {
+   std::string cipher, op, engine;
+   size_t bytes;        // Payload per operation (0 for key setup)
+   uint64_t iterations; // Operations per timed batch
+   double nsPerOp, nsPerOpMin, cyclesPerOp;
+   std::vector<std::pair<std::string, double>> extra; // Case-specific fields (latency percentiles)
+};
+
+volatile uint8_t sink;
+
+inline uint64_t cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+   return __rdtsc();
+#else
+   return 0;
+#endif
+}
+
+inline double nowNs() {
+   return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//  TSC ticks per ns, measured against the steady clock over ~50 ms
+inline double tscGhz() {
+   double t0 = nowNs();
+   uint64_t c0 = cycles();
+   while (nowNs() - t0 < 50e6) {
+   }
+   return (double)(cycles() - c0) / (nowNs() - t0);
+}
+
+template <class Fn> Result measure(const Options &opt, std::string cipher, std::string op, std::string engine, size_t bytes, Fn &&fn) {
+   fn(); // warm-up: caches, page faults, lazily built tables
+   uint64_t iters = 1;
+   for (;;) { // double the batch until it runs for minMs
+      double t0 = nowNs();
+      for (uint64_t i = 0; i < iters; i++)
+         fn();
+      double elapsed = nowNs() - t0;
+      if (elapsed >= opt.minMs * 1e6)
+         break;
+      iters = elapsed < opt.minMs * 1e5 ? iters * 2 : (uint64_t)(iters * opt.minMs * 1e6 / elapsed) + 1;
+   }
+
+   std::vector<double> ns(opt.reps), cyc(opt.reps);
+   for (int r = 0; r < opt.reps; r++) {
+      double start = nowNs();
+      uint64_t c0 = cycles();
+      for (uint64_t i = 0; i < iters; i++)
+         fn();
+      cyc[r] = (double)(cycles() - c0) / iters;
+      ns[r] = (nowNs() - start) / iters;
+   }
+   double best = *std::min_element(ns.begin(), ns.end());
+   std::nth_element(ns.begin(), ns.begin() + opt.reps / 2, ns.end());
+   std::nth_element(cyc.begin(), cyc.begin() + opt.reps / 2, cyc.end());
+   Result res{cipher, op, engine, bytes, iters, ns[opt.reps / 2], best, cyc[opt.reps / 2], {}};
+   std::cerr << "  " << std::left << std::setw(10) << res.cipher << std::setw(22) << res.op << std::setw(10) << res.engine
+             << std::right << std::setw(10) << bytes << " B " << std::fixed << std::setprecision(1) << std::setw(14)
+             << res.nsPerOp << " ns/op";
+   if (bytes)
+      std::cerr << std::setprecision(2) << std::setw(10) << res.cyclesPerOp / bytes << " cyc/B";
+   std::cerr << endl;
+   return res;
+}
+
+/*----------------------------------------------------JSON Output----------------------------------------------------*/
+// Flat list of results plus the configuration needed to compare two runs. All strings are plain ASCII.
+inline void writeJson(std::ostream &os, const Options &opt, double ghz, const std::vector<Result> &results) {
+   auto boolean = [](bool b) { return b ? "true" : "false"; };
+   os << std::setprecision(6) << std::defaultfloat;
+   os << "{\n  \"suite\": \"cryptography-lab-bench\",\n  \"format\": 1,\n  \"config\": {\n"
+      << "    \"compiler\": \"" << __VERSION__ << "\",\n"
+      << "    \"reps\": " << opt.reps << ",\n"
+      << "    \"min_ms\": " << opt.minMs << ",\n"
+      << "    \"threads\": " << opt.threads << ",\n"
+      << "    \"engine\": \"" << aes::engineName(aes::resolveEngine(opt.engine)) << "\",\n"
+      << "    \"aesni\": " << boolean(aes::hasAesni()) << ",\n"
+      << "    \"avx2\": " << boolean(aes::hasAvx2()) << ",\n"
+      << "    \"pclmul\": " << boolean(aes::hasPclmul()) << ",\n"
+      << "    \"forced_portable\": " << boolean(aes::forcePortableFlag()) << ",\n"
+      << "    \"bignum_avx2\": " << boolean(bn::hasAvx2()) << ",\n"
+      << "    \"sha_ni\": " << boolean(sha::hasShaNi()) << ",\n"
+      << "    \"tsc_ghz\": " << ghz << "\n  },\n  \"results\": [";
+   for (size_t i = 0; i < results.size(); i++) {
+      const Result &r = results[i];
+      os << (i ? ",\n" : "\n") << "    {\"cipher\": \"" << r.cipher << "\", \"op\": \"" << r.op << "\", \"engine\": \"" << r.engine
+         << "\", \"bytes\": " << r.bytes << ", \"iterations\": " << r.iterations << ", \"ns_per_op\": " << r.nsPerOp
+         << ", \"ns_per_op_min\": " << r.nsPerOpMin << ", \"cycles_per_op\": " << r.cyclesPerOp;
+      for (const auto &field : r.extra)
+         os << ", \"" << field.first << "\": " << field.second;
+      if (r.bytes)
+         os << ", \"cycles_per_byte\": " << r.cyclesPerOp / r.bytes << ", \"mb_per_s\": " << r.bytes * 1e3 / r.nsPerOp;
+      os << "}";
+   }
+   os << "\n  ]\n}\n";
+}
+
+/*----------------------------------------------------AES Cases----------------------------------------------------*/
+template <int KeyBits> void aesCases(const Options &opt, aes::ThreadPool &pool, std::vector<Result> &out) {
+   const std::string name = "AES-" + std::to_string(KeyBits);
+   std::mt19937 eng(KeyBits);
+   uint8_t key[KeyBits / 8], block[16], iv[16];
+   for (auto &b : key)
+      b = (uint8_t)eng();
+   for (int i = 0; i < 16; i++)
+      block[i] = (uint8_t)eng(), iv[i] = (uint8_t)eng();
+
+   // Key expansion: AES-NI assisted where the host has it (never for AES-192), portable otherwise
+   aes::KeySchedule<KeyBits> ks;
+   out.push_back(measure(opt, name, "key_expansion", (KeyBits != 192 && aes::hasAesni()) ? "AES-NI" : "portable", 0, [&] {
+      key[0]++;
+      ks.expand(key);
+      sink = ks.enc[16];
+   }));
+   ks.expand(key);
+
+   // Single block, chained through the same buffer so each call waits on the last (latency, not throughput)
+   for (aes::Engine e : {aes::Engine::Bytewise, aes::Engine::TTable, aes::Engine::AESNI, aes::Engine::Bitsliced}) {
+      if (e == aes::Engine::AESNI && !aes::hasAesni())
+         continue;
+      const AES<KeyBits> cipher(e);
+      out.push_back(measure(opt, name, "encrypt_block", aes::engineName(e), BLOCK_SIZE, [&] {
+         cipher.encryptBlock(ks, block, block);
+         sink = block[0];
+      }));
+      out.push_back(measure(opt, name, "decrypt_block", aes::engineName(e), BLOCK_SIZE, [&] {
+         cipher.decryptBlock(ks, block, block);
+         sink = block[0];
+      }));
+   }
+
+   // Bulk modes, 16 B to maxSize in steps of 4x
+   std::vector<uint8_t> in(opt.maxSize), buf(opt.maxSize);
+   for (auto &b : in)
+      b = (uint8_t)eng();
+   const char *engine = aes::engineName(aes::resolveEngine(opt.engine));
+   aes::GCM<KeyBits> gcm(ks, opt.engine);
+   uint8_t tag[16];
+   for (size_t len = 16; len <= opt.maxSize; len *= 4) {
+      out.push_back(measure(opt, name, "ecb_encrypt", engine, len, [&] {
+         aes::encryptECB(ks, in.data(), buf.data(), len, pool, opt.engine);
+         sink = buf[0];
+      }));
+      out.push_back(measure(opt, name, "ecb_decrypt", engine, len, [&] {
+         aes::decryptECB(ks, in.data(), buf.data(), len, pool, opt.engine);
+         sink = buf[0];
+      }));
+      out.push_back(measure(opt, name, "ctr", engine, len, [&] {
+         aes::cryptCTR(ks, iv, in.data(), buf.data(), len, pool, opt.engine);
+         sink = buf[0];
+      }));
+      out.push_back(measure(opt, name, "gcm_encrypt", engine, len, [&] {
+         gcm.start(iv);
+         gcm.encrypt(in.data(), buf.data(), len);
+         gcm.finish(tag);
+         sink = tag[0];
+      }));
+      if (opt.threads > 1)
+         out.push_back(measure(opt, name, "gcm_encrypt_parallel", engine, len, [&] {
+            gcm.start(iv);
+            gcm.encryptParallel(in.data(), buf.data(), len, pool);
+            gcm.finish(tag);
+            sink = tag[0];
+         }));
+   }
+}
+
+/*----------------------------------------------------Random Byte Cases----------------------------------------------------*/
+// aes::randomBytes (this thread's CTR_DRBG, refilled in bulk) against what it replaced: a std::random_device
+// constructed per call, one 32-bit draw per 4 bytes. Sizes are a nonce, a key, a prime candidate and a bulk read.
+inline void randomCases(const Options &opt, std::vector<Result> &out) {
+   const char *engine = aes::engineName(aes::resolveEngine(aes::Engine::Auto));
+   std::vector<uint8_t> buf(64 << 10);
+   for (size_t len : {12, 32, 256, 64 << 10}) {
+      out.push_back(measure(opt, "CTR_DRBG", "generate", engine, len, [&] {
+         aes::randomBytes(buf.data(), len);
+         sink = buf[0];
+      }));
+      if (len <= 256)
+         out.push_back(measure(opt, "RandomDev", "generate", "os", len, [&] {
+            std::random_device rd;
+            for (size_t i = 0; i < len; i += 4)
+               aes::store32(buf.data() + i, rd());
+            sink = buf[0];
+         }));
+   }
+}
+
+/*----------------------------------------------------Key Registry Cases----------------------------------------------------*/
+// One block per request for 4096 tenants interleaved. "expand" re-derives the tenant's schedule every request;
+// "reg_hot" leases it from a 1024-slot KeyRegistry while 512 tenants are active; "reg_churn" walks all 4096
+// round-robin, so every lease misses and recycles a slot (the worst case the bounded pool can cost).
+template <int KeyBits> void keyRegistryCases(const Options &opt, std::vector<Result> &out) {
+   const std::string name = "AES-" + std::to_string(KeyBits);
+   constexpr size_t KEY_BYTES = KeyBits / 8;
+   const size_t tenants = 4096, hot = 512;
+   aes::KeyRegistry<KeyBits> registry(1024);
+   std::vector<uint8_t> keys(tenants * KEY_BYTES);
+   std::vector<typename aes::KeyRegistry<KeyBits>::Handle> handles(tenants);
+   std::mt19937 eng(KeyBits);
+   for (auto &b : keys)
+      b = (uint8_t)eng();
+   for (size_t t = 0; t < tenants; t++)
+      handles[t] = registry.add(keys.data() + t * KEY_BYTES);
+   const AES<KeyBits> cipher(opt.engine);
+   uint8_t block[BLOCK_SIZE] = {0};
+   size_t next = 0;
+   out.push_back(measure(opt, name, "tenant_block", "expand", BLOCK_SIZE, [&] {
+      next = (next + 7) % tenants;
+      aes::KeySchedule<KeyBits> ks(keys.data() + next * KEY_BYTES);
+      cipher.encryptBlock(ks, block, block);
+      sink = block[0];
+   }));
+   out.push_back(measure(opt, name, "tenant_block", "reg_hot", BLOCK_SIZE, [&] {
+      next = (next + 7) % hot;
+      cipher.encryptBlock(registry.acquire(handles[next]), block, block);
+      sink = block[0];
+   }));
+   Result churn = measure(opt, name, "tenant_block", "reg_churn", BLOCK_SIZE, [&] {
+      next = (next + 1) % tenants;
+      cipher.encryptBlock(registry.acquire(handles[next]), block, block);
+      sink = block[0];
+   });
+   churn.extra = {{"tenants", (double)tenants}, {"slots", (double)registry.slots()}, {"pool_bytes", (double)registry.poolBytes()}};
+   out.push_back(churn);
+}
+
+/*----------------------------------------------------Feistel Cases----------------------------------------------------*/
+// "word" = FeistelEngine on two uint64_t halves, "bitset" = the FeistelCipher adapter on top of it,
+// "bitloop" = the original bit-by-bit rounds (below), kept as the baseline and as a known answer for the other two
+inline std::bitset<SIZE> feistelBitLoop(std::bitset<SIZE> data, const std::vector<std::bitset<HALF_SIZE>> &keys, bool decrypt) {
+   std::bitset<HALF_SIZE> left, right;
+   for (size_t i = 0; i < HALF_SIZE; i++) {
+      left[i] = data[i];
+      right[i] = data[i + HALF_SIZE];
+   }
+   for (size_t n = 0; n < keys.size(); n++) {
+      const std::bitset<HALF_SIZE> &key = keys[decrypt ? keys.size() - 1 - n : n];
+      std::bitset<HALF_SIZE> temp;
+      for (size_t j = 0; j < HALF_SIZE; j++)
+         temp[j] = (right[j] ^ key[j]) ^ left[j];
+      left = right;
+      right = temp;
+      for (size_t j = 0; j < HALF_SIZE; j++) {
+         data[j] = left[j];
+         data[j + HALF_SIZE] = right[j];
+      }
+   }
+   for (size_t j = 0; j < HALF_SIZE; j++) {
+      data[j] = right[j];
+      data[j + HALF_SIZE] = left[j];
+   }
+   return data;
+}
+
+inline void feistelCases(const Options &opt, std::vector<Result> &out) {
+   std::mt19937_64 eng(0xFE15);
+   FeistelCipher cipher;
+   std::bitset<SIZE> block = halvesToBitset(eng(), eng());
+   for (int rounds : {1, 2, 4, 8, 16, 32, 64}) {
+      std::vector<std::bitset<HALF_SIZE>> keys;
+      std::vector<uint64_t> words;
+      for (int i = 0; i < rounds; i++) {
+         words.push_back(eng());
+         keys.emplace_back(words.back());
+      }
+      const FeistelEngine<> engine(words);
+      std::bitset<SIZE> expect = feistelBitLoop(block, keys, false);
+      if (cipher.encrypt(block, keys) != expect || cipher.decrypt(expect, keys) != block)
+         throw std::runtime_error("Feistel word engine disagrees with the bit-by-bit rounds");
+
+      std::string op = std::to_string(rounds) + "_rounds";
+      for (bool dec : {false, true}) {
+         const std::string name = (dec ? "decrypt_" : "encrypt_") + op;
+         out.push_back(measure(opt, "Feistel", name, "bitloop", SIZE / 8, [&] {
+            block = feistelBitLoop(block, keys, dec);
+            sink = (uint8_t)block[0];
+         }));
+         out.push_back(measure(opt, "Feistel", name, "bitset", SIZE / 8, [&] {
+            block = dec ? cipher.decrypt(block, keys) : cipher.encrypt(block, keys);
+            sink = (uint8_t)block[0];
+         }));
+         uint64_t left, right;
+         bitsetToHalves(block, left, right);
+         out.push_back(measure(opt, "Feistel", name, "word", SIZE / 8, [&] {
+            if (dec)
+               engine.decrypt(left, right);
+            else
+               engine.encrypt(left, right);
+            sink = (uint8_t)left;
+         }));
+      }
+   }
+}
+
+// Feistel<BlockBits, 16, RoundFn>: unrolled rounds, engine = round-function policy. "xor" at 128 bits is the same
+// cipher as "word" above, so the pair shows what compile-time rounds buy on their own.
+template <size_t BlockBits, template <size_t> class RoundFn>
+void feistelPolicyCase(const Options &opt, const std::string &policy, std::vector<Result> &out) {
+   using Cipher = Feistel<BlockBits, 16, RoundFn>;
+   std::mt19937_64 eng(BlockBits);
+   typename Cipher::Keys keys;
+   for (uint64_t &k : keys)
+      k = eng();
+   const Cipher cipher(keys);
+   uint64_t left = eng() & Cipher::MASK, right = eng() & Cipher::MASK;
+   const std::string name = BlockBits == SIZE ? "Feistel" : "Feistel" + std::to_string(BlockBits);
+   out.push_back(measure(opt, name, "encrypt_16_rounds", policy, BlockBits / 8, [&] {
+      cipher.encrypt(left, right);
+      sink = (uint8_t)left;
+   }));
+   out.push_back(measure(opt, name, "decrypt_16_rounds", policy, BlockBits / 8, [&] {
+      cipher.decrypt(left, right);
+      sink = (uint8_t)left;
+   }));
+}
+
+inline void feistelPolicyCases(const Options &opt, std::vector<Result> &out) {
+   feistelPolicyCase<128, XorRound>(opt, "xor", out);
+   feistelPolicyCase<128, ArxRound>(opt, "arx", out);
+   feistelPolicyCase<128, SpnRound>(opt, "spn", out);
+   feistelPolicyCase<32, ArxRound>(opt, "arx", out);
+   feistelPolicyCase<32, SpnRound>(opt, "spn", out);
+}
+
+// Byte-buffer modes on Feistel<128, 16, RoundFn>, 16 B to maxSize in steps of 4x. CBC encryption is serial;
+// CBC decryption and CTR run four blocks per lane group and spread chunks over the pool.
+template <template <size_t> class RoundFn>
+void feistelBulkCases(const Options &opt, lab::ThreadPool &pool, const std::string &policy, std::vector<Result> &out) {
+   using Cipher = Feistel<128, 16, RoundFn>;
+   std::mt19937_64 eng(SIZE);
+   typename Cipher::Keys keys;
+   for (uint64_t &k : keys)
+      k = eng();
+   const Cipher cipher(keys);
+   uint8_t iv[Cipher::BLOCK_BYTES];
+   for (uint8_t &b : iv)
+      b = (uint8_t)eng();
+   std::vector<uint8_t> in(opt.maxSize), buf(Cipher::paddedSize(opt.maxSize)), back(buf.size());
+   for (auto &b : in)
+      b = (uint8_t)eng();
+
+   size_t ctLen = cipher.encryptCBC(iv, in.data(), in.size(), buf.data());
+   bool ok = cipher.decryptCBC(iv, buf.data(), ctLen, back.data(), pool) == in.size() &&
+             std::equal(in.begin(), in.end(), back.begin());
+   cipher.cryptCTR(1, in.data(), in.size(), buf.data(), pool);
+   cipher.cryptCTR(1, buf.data(), in.size(), back.data(), pool);
+   if (!ok || !std::equal(in.begin(), in.end(), back.begin()))
+      throw std::runtime_error("Feistel bulk modes do not round-trip");
+
+   for (size_t len = 16; len <= opt.maxSize; len *= 4) {
+      out.push_back(measure(opt, "Feistel", "cbc_encrypt", policy, len, [&] {
+         ctLen = cipher.encryptCBC(iv, in.data(), len, buf.data());
+         sink = buf[0];
+      }));
+      out.push_back(measure(opt, "Feistel", "cbc_decrypt", policy, len, [&] {
+         cipher.decryptCBC(iv, buf.data(), ctLen, back.data(), pool);
+         sink = back[0];
+      }));
+      out.push_back(measure(opt, "Feistel", "ctr", policy, len, [&] {
+         cipher.cryptCTR(1, in.data(), len, buf.data(), pool);
+         sink = buf[0];
+      }));
+   }
+}
+
+/*----------------------------------------------------SHA Cases----------------------------------------------------*/
+// One message from 64 B to maxSize in steps of 16x, then hashMany() over 64 B and 1 KiB objects (bytes = the
+// whole batch). Each runs on the native paths and again with SHA_FORCE_PORTABLE, unless they are the same.
+template <class H> void shaCases(const Options &opt, const std::string &name, std::vector<Result> &out) {
+   std::vector<uint8_t> in(opt.maxSize);
+   std::mt19937 eng(H::DIGEST_SIZE);
+   for (auto &b : in)
+      b = (uint8_t)eng();
+   const bool wasForced = sha::forcePortableFlag();
+   for (bool portable : {false, true}) {
+      if (!portable && wasForced)
+         continue; // SHA_FORCE_PORTABLE=1: no native pass
+      if (portable && !wasForced && !sha::cpu().shani && !sha::cpu().avx2)
+         break; // the native pass was already portable
+      sha::setForcePortable(portable);
+      const bool shani = std::is_same<H, SHA256>::value && sha::cpu().shani;
+      if (!portable || shani)
+         for (size_t len = 64; len <= opt.maxSize; len *= 16)
+            out.push_back(measure(opt, name, "hash", shani && !portable ? "shani" : "portable", len, [&] {
+               typename H::Digest d = H::hash(in.data(), len);
+               sink = d[0];
+            }));
+      const size_t batch = std::min<size_t>(opt.maxSize, 1 << 20);
+      for (size_t objSize : {64, 1024}) {
+         const size_t count = batch / objSize;
+         std::vector<const uint8_t *> data(count);
+         std::vector<size_t> len(count, objSize);
+         for (size_t i = 0; i < count; i++)
+            data[i] = in.data() + i * objSize;
+         std::vector<typename H::Digest> digests(count);
+         Result res = measure(opt, name, "hash_many_" + std::to_string(objSize), H::manyEngine(), count * objSize, [&] {
+            H::hashMany(data.data(), len.data(), digests.data(), count);
+            sink = digests[0][0];
+         });
+         if (digests[count - 1] != H::hash(data[count - 1], objSize))
+            throw std::runtime_error(name + " hashMany disagrees with one-message hashing");
+         res.extra.push_back({"objects_per_s", count * 1e9 / res.nsPerOp});
+         out.push_back(res);
+      }
+   }
+   sha::setForcePortable(wasForced);
+}
+
+/*----------------------------------------------------RSA Cases----------------------------------------------------*/
+// Keygen is random (prime search), so it gets one sample per key and a latency distribution (nearest-rank
+// percentiles, ns_per_op = median) instead of a batch mean
+template <class Fn> Result latency(const std::string &cipher, const std::string &op, const std::string &engine, size_t samples, Fn &&fn) {
+   std::vector<double> ns, cyc;
+   for (size_t i = 0; i < samples; i++) {
+      double start = nowNs();
+      uint64_t c0 = cycles();
+      fn();
+      cyc.push_back((double)(cycles() - c0));
+      ns.push_back(nowNs() - start);
+   }
+   std::sort(ns.begin(), ns.end());
+   std::sort(cyc.begin(), cyc.end());
+   auto rank = [&](double pct) { return ns[std::min(ns.size() - 1, (size_t)std::ceil(pct / 100 * ns.size()) - 1)]; };
+   Result res{cipher, op, engine, 0, 1, rank(50), ns.front(), cyc[(cyc.size() - 1) / 2], {}};
+   res.extra = {{"samples", (double)samples}, {"p50_ns", rank(50)}, {"p90_ns", rank(90)}, {"p99_ns", rank(99)}, {"max_ns", ns.back()}};
+   std::cerr << "  " << std::left << std::setw(10) << cipher << std::setw(22) << op << std::right << std::fixed << std::setprecision(1)
+             << " p50 " << rank(50) / 1e6 << " ms  p90 " << rank(90) / 1e6 << " ms  p99 " << rank(99) / 1e6 << " ms  max "
+             << ns.back() / 1e6 << " ms  (" << samples << " samples)" << endl;
+   return res;
+}
+
+// Keygen latency, then raw encrypt (e = 65537) and CRT decrypt of one modulus-sized block
+template <size_t Bits> void rsaCases(const Options &opt, size_t samples, std::vector<Result> &out) {
+   using Num = typename RSA<Bits>::Num;
+   const std::string name = "RSA-" + std::to_string(Bits);
+   out.push_back(latency(name, "keygen", "sieve+mr", samples, [&] {
+      RSA<Bits> rsa(Bits, Num(RSA<Bits>::DEFAULT_EXPONENT), (unsigned)opt.threads);
+      sink = (uint8_t)rsa.modulus().low64();
+   }));
+   const RSA<Bits> rsa(Bits, Num(RSA<Bits>::DEFAULT_EXPONENT), (unsigned)opt.threads);
+   std::mt19937_64 eng(Bits);
+   Num m;
+   for (size_t i = 0; i < Num::LIMBS; i++)
+      m.limb[i] = eng();
+   m = m % rsa.modulus();
+   out.push_back(measure(opt, name, "encrypt", "montgomery", Bits / 8, [&] {
+      m = rsa.encryptBlock(m);
+      sink = (uint8_t)m.low64();
+   }));
+   out.push_back(measure(opt, name, "decrypt", "crt", Bits / 8, [&] {
+      m = rsa.decryptBlock(m);
+      sink = (uint8_t)m.low64();
+   }));
+
+   // Padded: bytes = the message payload of one full block, so MB/s is plaintext throughput
+   using Padding = typename RSA<Bits>::Padding;
+   const size_t k = rsa.modulusBytes();
+   std::vector<uint8_t> msg(k), block(k);
+   for (auto &b : msg)
+      b = (uint8_t)eng();
+   for (Padding pad : {Padding::OAEP, Padding::PKCS1v15}) {
+      const std::string padName = pad == Padding::OAEP ? "oaep" : "pkcs1v15";
+      const size_t len = rsa.maxMessageBytes(pad);
+      if (!len)
+         continue; // OAEP-SHA-256 needs at least a 528-bit modulus
+      out.push_back(measure(opt, name, padName + "_encrypt", "montgomery", len, [&] {
+         rsa.encrypt(msg.data(), len, block.data(), k, pad);
+         sink = block[0];
+      }));
+      out.push_back(measure(opt, name, padName + "_decrypt", "crt", len, [&] {
+         sink = (uint8_t)rsa.decrypt(block.data(), k, msg.data(), k, pad);
+      }));
+   }
+}
+
+// One public key, many signatures: verifyBatch over the pool, with the four-lane AVX2 multiplier and without it.
+// ns_per_op is per batch; ops_per_s_per_core divides by the pool size, so it stays flat while the pool scales.
+template <size_t Bits> void rsaBatchCases(const Options &opt, lab::ThreadPool &pool, std::vector<Result> &out) {
+   using Num = typename RSA<Bits>::Num;
+   const std::string name = "RSA-" + std::to_string(Bits);
+   const RSA<Bits> rsa(Bits, Num(RSA<Bits>::DEFAULT_EXPONENT), (unsigned)opt.threads);
+   const size_t count = opt.quick ? 64 : 256;
+   std::mt19937_64 eng(Bits);
+   std::vector<Num> msg(count), sig(count);
+   for (size_t i = 0; i < count; i++) {
+      for (size_t j = 0; j < Num::LIMBS; j++)
+         msg[i].limb[j] = eng();
+      msg[i] = msg[i] % rsa.modulus();
+      sig[i] = rsa.sign(msg[i]);
+   }
+   std::unique_ptr<bool[]> ok(new bool[count]);
+   for (bool avx2 : {true, false}) {
+      if (avx2 && !bn::hasAvx2())
+         continue;
+      const bool wasForced = bn::forcePortableFlag();
+      bn::setForcePortable(!avx2);
+      Result res = measure(opt, name, "verify_batch", avx2 ? "avx2x4" : "scalar", count * rsa.modulusBytes(), [&] {
+         sink = (uint8_t)rsa.verifyBatch(msg.data(), sig.data(), ok.get(), count, pool);
+      });
+      bn::setForcePortable(wasForced);
+      if (std::count(ok.get(), ok.get() + count, true) != (std::ptrdiff_t)count)
+         throw std::runtime_error(name + " batch verification rejected a valid signature");
+      double opsPerSec = count * 1e9 / res.nsPerOp;
+      res.extra = {{"batch", (double)count}, {"threads", (double)pool.size()}, {"ops_per_s", opsPerSec},
+                   {"ops_per_s_per_core", opsPerSec / pool.size()}};
+      std::cerr << "  " << std::setw(42) << "" << std::fixed << std::setprecision(0) << opsPerSec << " verify/s, "
+                << opsPerSec / pool.size() << " verify/s/core" << endl;
+      out.push_back(res);
+   }
+}
+
+// RSASSA-PSS over 1 KiB messages (roughly a certificate body): sign, verify, the batch path, and a verifier that
+// only holds (n, e) - parsing the key for every signature versus taking it from the PublicKeyCache
+template <size_t Bits> void rsaPssCases(const Options &opt, lab::ThreadPool &pool, std::vector<Result> &out) {
+   using Num = typename RSA<Bits>::Num;
+   const std::string name = "RSA-" + std::to_string(Bits);
+   const RSA<Bits> rsa(Bits, Num(RSA<Bits>::DEFAULT_EXPONENT), (unsigned)opt.threads);
+   const size_t k = rsa.modulusBytes(), len = 1024, count = opt.quick ? 64 : 256;
+   std::mt19937_64 eng(Bits);
+   std::vector<uint8_t> msgs(count * len), sigs(count * k);
+   for (auto &b : msgs)
+      b = (uint8_t)eng();
+   std::vector<const uint8_t *> msg(count), sig(count);
+   std::vector<size_t> lens(count, len);
+   for (size_t i = 0; i < count; i++) {
+      msg[i] = msgs.data() + i * len;
+      sig[i] = sigs.data() + i * k;
+      rsa.signPSS(msg[i], len, sigs.data() + i * k);
+   }
+   std::vector<uint8_t> scratch(k);
+   out.push_back(measure(opt, name, "pss_sign", "crt", len, [&] {
+      rsa.signPSS(msg[0], len, scratch.data());
+      sink = scratch[0];
+   }));
+   out.push_back(measure(opt, name, "pss_verify", "montgomery", len, [&] { sink = rsa.verifyPSS(msg[0], len, sig[0]); }));
+
+   std::unique_ptr<bool[]> ok(new bool[count]);
+   Result res = measure(opt, name, "pss_verify_batch", bn::hasAvx2() ? "avx2x4" : "scalar", count * len, [&] {
+      sink = (uint8_t)rsa.verifyPSSBatch(msg.data(), lens.data(), sig.data(), ok.get(), count, pool);
+   });
+   if (std::count(ok.get(), ok.get() + count, true) != (std::ptrdiff_t)count)
+      throw std::runtime_error(name + " PSS batch verification rejected a valid signature");
+   res.extra = {{"batch", (double)count}, {"ops_per_s", count * 1e9 / res.nsPerOp}};
+   out.push_back(res);
+
+   const Num n = rsa.modulus(), e = rsa.exponent();
+   out.push_back(measure(opt, name, "pss_verify_new_key", "parse", len, [&] { sink = RSA<Bits>(n, e).verifyPSS(msg[0], len, sig[0]); }));
+   PublicKeyCache<Bits> cache;
+   out.push_back(measure(opt, name, "pss_verify_cached", "lru", len, [&] { sink = cache.verifyPSS(n, e, msg[0], len, sig[0]); }));
+}
+
+// Without the CRT: a random odd n stands in for a key, which is all the exponentiation cost depends on.
+// "private" = full-length exponent through the fixed-window powSecret (what d costs), "public" = 65537 through the
+// sliding window; bytes = one modulus-sized block
+template <size_t Bits> void modexpCases(const Options &opt, std::vector<Result> &out) {
+   using Num = bn::UInt<Bits>;
+   std::mt19937_64 eng(Bits);
+   Num n, d, m;
+   for (size_t i = 0; i < Num::LIMBS; i++)
+      n.limb[i] = eng(), d.limb[i] = eng(), m.limb[i] = eng();
+   n.setBit(Bits - 1);
+   n.limb[0] |= 1;
+   d = d % n;
+   m = m % n;
+   const bn::Montgomery<Bits> mont(n);
+   const std::string name = "RSA-" + std::to_string(Bits);
+   out.push_back(measure(opt, name, "modexp_public", "montgomery", Bits / 8, [&] {
+      m = mont.pow(m, Num(65537));
+      sink = (uint8_t)m.low64();
+   }));
+   out.push_back(measure(opt, name, "modexp_private", "montgomery", Bits / 8, [&] {
+      m = mont.powSecret(m, d);
+      sink = (uint8_t)m.low64();
+   }));
+}
+
+/*----------------------------------------------------Key Exchange Cases----------------------------------------------------*/
+// Ephemeral key generation through the fixed-base comb versus the generic path (powSecret over the same exponent
+// length for FFDH, the ladder for X25519), then one side of a handshake: fresh key pair + shared secret with a fixed peer
+template <size_t Bits> void ffdhCases(const Options &opt, std::vector<Result> &out) {
+   using DH = kex::FFDH<Bits>;
+   const std::string name = "FFDH-" + std::to_string(Bits);
+   const DH &group = DH::modp();
+   const bn::Montgomery<Bits> mont(group.prime());
+   const typename DH::KeyPair peer = group.generateKeyPair();
+   typename DH::Num x = group.generateKeyPair().privateKey; // bit 0 flips per call so the loop can't be hoisted
+   out.push_back(measure(opt, name, "keygen", "comb", 0, [&] { sink = (uint8_t)group.generateKeyPair().publicKey.low64(); }));
+   out.push_back(measure(opt, name, "keygen", "window", 0, [&] {
+      x.limb[0] ^= 1;
+      sink = (uint8_t)mont.powSecret(group.generator(), x, group.privateBits()).low64();
+   }));
+   Result res = measure(opt, name, "handshake", "comb", 0, [&] {
+      sink = (uint8_t)group.sharedSecret(group.generateKeyPair().privateKey, peer.publicKey).low64();
+   });
+   res.extra.push_back({"handshakes_per_s", 1e9 / res.nsPerOp});
+   out.push_back(res);
+}
+
+inline void x25519Cases(const Options &opt, std::vector<Result> &out) {
+   using kex::X25519;
+   const X25519::KeyPair peer = X25519::generateKeyPair();
+   X25519::Key key = peer.privateKey;
+   out.push_back(measure(opt, "X25519", "keygen", "comb", 0, [&] {
+      sink = X25519::publicKey(key)[0];
+      key[0]++;
+   }));
+   out.push_back(measure(opt, "X25519", "keygen", "ladder", 0, [&] {
+      sink = X25519::scalarMult(key, X25519::basePoint())[0];
+      key[0]++;
+   }));
+   Result res = measure(opt, "X25519", "handshake", "comb", 0, [&] {
+      sink = X25519::sharedSecret(X25519::generateKeyPair().privateKey, peer.publicKey)[0];
+   });
+   res.extra.push_back({"handshakes_per_s", 1e9 / res.nsPerOp});
+   out.push_back(res);
+}
+
+inline aes::Engine parseEngine(const std::string &s) {
+   for (aes::Engine e : {aes::Engine::Auto, aes::Engine::Bytewise, aes::Engine::TTable, aes::Engine::AESNI, aes::Engine::Bitsliced}) {
+      std::string n; // "T-Table" -> "ttable", "AES-NI" -> "aesni"
+      for (const char *c = aes::engineName(e); *c; c++)
+         if (*c != '-')
+            n += (char)tolower(*c);
+      if (n == s)
+         return e;
+   }
+   throw std::invalid_argument("Unknown engine: " + s);
+}
+
+} // namespace bench
+
+int main(int argc, char *argv[]) {
+   bench::Options opt;
+   try {
+      for (int i = 1; i < argc; i++) {
+         std::string a = argv[i];
+         auto next = [&]() -> std::string {
+            if (i + 1 >= argc)
+               throw std::invalid_argument("Missing value for " + a);
+            return argv[++i];
+         };
+         if (a == "--quick") {
+            opt.quick = true;
+            opt.reps = 3;
+            opt.minMs = 5;
+            opt.maxSize = std::min<size_t>(opt.maxSize, 1 << 20);
+         } else if (a == "--only")
+            opt.only = next();
+         else if (a == "--engine")
+            opt.engine = bench::parseEngine(next());
+         else if (a == "--threads")
+            opt.threads = std::stoul(next());
+         else if (a == "--reps")
+            opt.reps = std::stoi(next());
+         else if (a == "--min-ms")
+            opt.minMs = std::stod(next());
+         else if (a == "--max-size")
+            opt.maxSize = std::stoull(next());
+         else if (a == "-o")
+            opt.outPath = next();
+         else
+            throw std::invalid_argument("Unknown option: " + a);
+      }
+      if (opt.reps < 1 || opt.threads < 1 || opt.maxSize < 16)
+         throw std::invalid_argument("--reps and --threads must be at least 1, --max-size at least 16");
+      if (!opt.only.empty() && opt.only != "aes" && opt.only != "feistel" && opt.only != "rsa" && opt.only != "kex" &&
+          opt.only != "sha")
+         throw std::invalid_argument("--only takes aes, feistel, rsa, kex or sha");
+   } catch (const std::exception &e) {
+      std::cerr << e.what() << endl;
+      return 2;
+   }
+
+   double ghz = bench::tscGhz();
+   std::vector<bench::Result> results;
+   aes::ThreadPool pool(opt.threads);
+   if (opt.only.empty() || opt.only == "aes") {
+      bench::aesCases<128>(opt, pool, results);
+      bench::aesCases<192>(opt, pool, results);
+      bench::aesCases<256>(opt, pool, results);
+      bench::randomCases(opt, results);
+      bench::keyRegistryCases<128>(opt, results);
+      bench::keyRegistryCases<256>(opt, results);
+   }
+   if (opt.only.empty() || opt.only == "feistel") {
+      bench::feistelCases(opt, results);
+      bench::feistelPolicyCases(opt, results);
+      bench::feistelBulkCases<ArxRound>(opt, pool, "arx", results);
+      bench::feistelBulkCases<SpnRound>(opt, pool, "spn", results);
+   }
+   if (opt.only.empty() || opt.only == "rsa") {
+      bench::rsaCases<512>(opt, opt.quick ? 8 : 40, results);
+      bench::rsaCases<1024>(opt, opt.quick ? 8 : 40, results);
+      bench::rsaCases<2048>(opt, opt.quick ? 4 : 20, results);
+      if (!opt.quick) {
+         bench::rsaCases<3072>(opt, 8, results);
+         bench::rsaCases<4096>(opt, 4, results);
+      }
+      bench::rsaBatchCases<1024>(opt, pool, results);
+      bench::rsaBatchCases<2048>(opt, pool, results);
+      if (!opt.quick)
+         bench::rsaBatchCases<4096>(opt, pool, results);
+      bench::rsaPssCases<2048>(opt, pool, results);
+      if (!opt.quick)
+         bench::rsaPssCases<4096>(opt, pool, results);
+      bench::modexpCases<1024>(opt, results);
+      bench::modexpCases<2048>(opt, results);
+      bench::modexpCases<3072>(opt, results);
+      bench::modexpCases<4096>(opt, results);
+   }
+   if (opt.only.empty() || opt.only == "kex") {
+      bench::x25519Cases(opt, results);
+      bench::ffdhCases<2048>(opt, results);
+      bench::ffdhCases<3072>(opt, results);
+      if (!opt.quick)
+         bench::ffdhCases<4096>(opt, results);
+   }
+   if (opt.only.empty() || opt.only == "sha") {
+      bench::shaCases<SHA256>(opt, "SHA-256", results);
+      bench::shaCases<SHA512>(opt, "SHA-512", results);
+   }
+
+   if (opt.outPath.empty()) {
+      bench::writeJson(cout, opt, ghz, results);
+      return 0;
+   }
+   std::ofstream file(opt.outPath);
+   bench::writeJson(file, opt, ghz, results);
+   if (!file) {
+      std::cerr << "Could not write " << opt.outPath << endl;
+      return 1;
+   }
+   std::cerr << "Wrote " << results.size() << " results to " << opt.outPath << endl;
+   return 0;
+}
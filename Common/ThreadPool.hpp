@@ -0,0 +1,136 @@
+/*----------------------------------------------------Worker Thread Pool 🧵----------------------------------------------------*/
+/* Author      : Hassan (a.k.a. The Eagle 🦅)
+ * Description : Fixed pool of worker threads with a blocking parallelFor, shared by every module that fans work out:
+ *               - AES bulk ECB/CTR/GCM (AES.hpp, AESFile.cpp)
+ *               - Batched RSA public-key operations (RSA.hpp)
+ *               - Feistel CBC decryption and CTR (FeistelCipher.hpp)
+ *               Tasks may throw: the first exception reaches the caller of parallelFor.
+ *
+ * Usage       : #include "ThreadPool.hpp" — lab::defaultPool() is sized to the machine
+ *
+ * License     : Public Domain / MIT — use it, break it, improve it 👨‍💻
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace lab {
+
+// One job at a time: parallelFor hands out indices from a shared counter, and the calling thread works too
+class ThreadPool {
+ public:
+   //  threads = 0 uses every hardware thread; the calling thread always works as one of them
+   explicit ThreadPool(size_t threads = 0) {
+      if (threads == 0)
+         threads = std::max(1u, std::thread::hardware_concurrency());
+      for (size_t i = 1; i < threads; i++)
+         workers.emplace_back([this] { workerLoop(); });
+   }
+   ~ThreadPool() {
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         stopping = true;
+      }
+      wake.notify_all();
+      for (std::thread &t : workers)
+         t.join();
+   }
+   ThreadPool(const ThreadPool &) = delete;
+   ThreadPool &operator=(const ThreadPool &) = delete;
+
+   size_t size() const { return workers.size() + 1; }
+
+   //  Calls fn(i) for every i in [0, n) across the pool and returns once all calls have finished.
+   //  If a call throws, no further indices are handed out and the first exception is rethrown here once every
+   //  thread has left fn. A parallelFor from inside a task of the same pool runs its loop serially on the
+   //  calling thread (the pool is busy with the outer job).
+   void parallelFor(size_t n, const std::function<void(size_t)> &fn) {
+      if (runningPool() == this) {
+         for (size_t i = 0; i < n; i++)
+            fn(i);
+         return;
+      }
+      std::lock_guard<std::mutex> oneJob(callMutex);
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         job = &fn;
+         jobSize = n;
+         next = 0;
+         pending = workers.size();
+         error = nullptr;
+         generation++;
+      }
+      wake.notify_all();
+      runTasks();
+      std::unique_lock<std::mutex> lock(mutex);
+      finished.wait(lock, [this] { return pending == 0; });
+      job = nullptr;
+      if (error)
+         std::rethrow_exception(std::exchange(error, nullptr));
+   }
+
+ private:
+   std::vector<std::thread> workers;
+   std::mutex mutex, callMutex;
+   std::condition_variable wake, finished;
+   const std::function<void(size_t)> *job = nullptr;
+   size_t jobSize = 0, pending = 0, generation = 0;
+   std::atomic<size_t> next{0};
+   std::exception_ptr error; // first exception of the current job
+   bool stopping = false;
+
+   //  The pool whose task this thread is running, if any
+   static const ThreadPool *&runningPool() {
+      static thread_local const ThreadPool *pool = nullptr;
+      return pool;
+   }
+
+   //  Never throws: a failing task stops the job and parks its exception for parallelFor
+   void runTasks() {
+      const ThreadPool *outer = std::exchange(runningPool(), this);
+      try {
+         for (size_t i = next.fetch_add(1); i < jobSize; i = next.fetch_add(1))
+            (*job)(i);
+      } catch (...) {
+         next = jobSize;
+         std::lock_guard<std::mutex> lock(mutex);
+         if (!error)
+            error = std::current_exception();
+      }
+      runningPool() = outer;
+   }
+   void workerLoop() {
+      size_t seen = 0;
+      for (;;) {
+         {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping)
+               return;
+            seen = generation;
+         }
+         runTasks();
+         std::lock_guard<std::mutex> lock(mutex);
+         if (--pending == 0)
+            finished.notify_one();
+      }
+   }
+};
+
+//  Process-wide pool sized to the machine, created on first use
+inline ThreadPool &defaultPool() {
+   static ThreadPool pool;
+   return pool;
+}
+
+} // namespace lab
@@ -0,0 +1,164 @@
+/*----------------------------------------------------SHA-2 Demo & Self-Checks #️⃣----------------------------------------------------*/
+/* Author      : Hassan (a.k.a. The Eagle 🦅)
+ * Description : Demo for SHA256.hpp / SHA512.hpp — hashes a string with both.
+ *               ./SHA --bench runs the FIPS 180-4 known answers on every path (portable, SHA-NI, multi-buffer)
+ *               and reports MB/s for single messages and for many small ones.
+ *
+ * Build       : g++ -std=c++17 -O2 SHA.cpp -o SHA
+ *
+ * License     : Public Domain / MIT — use it, break it, improve it 👨‍💻
+ */
+
+#include "SHA512.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+using std::cout;
+using std::endl;
+
+template <class H> std::string toHex(const typename H::Digest &d) {
+   static const char *digits = "0123456789abcdef";
+   std::string s;
+   for (uint8_t b : d) {
+      s += digits[b >> 4];
+      s += digits[b & 15];
+   }
+   return s;
+}
+
+/*----------------------------------------------------Known Answers----------------------------------------------------*/
+// FIPS 180-4 examples (and the empty string): one-shot, streamed in uneven pieces, and through hashMany()
+struct Vector {
+   std::string message, sha256, sha512;
+};
+
+static std::vector<Vector> vectors() {
+   return {
+       {"", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+        "cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce47d0d13c5d85f2b0ff8318d2877eec2f63b931bd47417a81a538327af927da3e"},
+       {"abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+        "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f"},
+       {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+        "204a8fc6dda82f0a0ced7beb8e08a41657c16ef468b228a8279be331a703c33596fd15c13b1b07f9aa1d3bea57789ca031ad85c7a71dd70354ec631238ca3445"},
+       {"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+        "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1",
+        "8e959b75dae313da8cf4f72814fc143f8f7779c6eb9f7fa17299aeadb6889018501d289e4900f7e4331b99dec4b5433ac7d329eeb6dd26545e96e55b874be909"},
+       {std::string(1000000, 'a'), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0",
+        "e718483d0ce769644e2e42c7bc15b4638e1f98b13b2044285632a803afa973ebde0ff244877ea60a4cb0432ce577c31beb009c5c2c49aa2e4eadb217ad8cc09b"},
+   };
+}
+
+template <class H> bool checkSingle(const std::vector<Vector> &vs, std::string Vector::*expected) {
+   bool ok = true;
+   for (const Vector &v : vs) {
+      H h;
+      const uint8_t *p = reinterpret_cast<const uint8_t *>(v.message.data());
+      for (size_t at = 0, step = 1; at < v.message.size(); at += step, step = step * 3 % 191 + 1)
+         h.update(p + at, std::min(step, v.message.size() - at));
+      ok = ok && toHex<H>(H::hash(v.message)) == v.*expected && toHex<H>(h.final()) == v.*expected;
+   }
+   return ok;
+}
+
+template <class H> bool checkMany(const std::vector<Vector> &vs, std::string Vector::*expected) {
+   // Every vector three times, so lanes finish at different blocks and pick up new messages mid-run
+   std::vector<const uint8_t *> data;
+   std::vector<size_t> len;
+   for (int r = 0; r < 3; r++)
+      for (const Vector &v : vs) {
+         data.push_back(reinterpret_cast<const uint8_t *>(v.message.data()));
+         len.push_back(v.message.size());
+      }
+   std::vector<typename H::Digest> out(data.size());
+   H::hashMany(data.data(), len.data(), out.data(), data.size());
+   bool ok = true;
+   for (size_t i = 0; i < out.size(); i++)
+      ok = ok && toHex<H>(out[i]) == vs[i % vs.size()].*expected;
+   return ok;
+}
+
+/*----------------------------------------------------Throughput----------------------------------------------------*/
+template <class Fn> double mbPerSec(size_t bytes, Fn &&fn) {
+   fn();
+   auto start = std::chrono::steady_clock::now();
+   fn();
+   std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+   return bytes / secs.count() / 1e6;
+}
+
+template <class H> void throughput(const char *name, const std::vector<uint8_t> &buf) {
+   typename H::Digest d;
+   cout << "  " << std::left << std::setw(8) << name << std::right << std::fixed << std::setprecision(1) << "one message "
+        << std::setw(8) << mbPerSec(buf.size(), [&] { d = H::hash(buf.data(), buf.size()); }) << " MB/s";
+   for (size_t objSize : {64, 1024}) {
+      const size_t count = buf.size() / objSize;
+      std::vector<const uint8_t *> data(count);
+      std::vector<size_t> len(count, objSize);
+      for (size_t i = 0; i < count; i++)
+         data[i] = buf.data() + i * objSize;
+      std::vector<typename H::Digest> out(count);
+      cout << "   " << std::setw(4) << objSize << " B objects " << std::setw(8)
+           << mbPerSec(buf.size(), [&] { H::hashMany(data.data(), len.data(), out.data(), count); }) << " MB/s";
+   }
+   cout << "   (" << H::manyEngine() << ")" << endl;
+}
+
+bool benchmark(size_t bytes = 16 << 20) {
+   const std::vector<Vector> vs = vectors();
+   std::vector<uint8_t> buf(bytes);
+   for (size_t i = 0; i < bytes; i++)
+      buf[i] = (uint8_t)(i * 131 + (i >> 9));
+   bool ok = true;
+   // SHA_FORCE_PORTABLE=1 (or an earlier setForcePortable(true)) keeps the native paths off for the whole run
+   const bool wasForced = sha::forcePortableFlag();
+   for (bool portable : {true, false}) {
+      if (!portable && (wasForced || (!sha::cpu().shani && !sha::cpu().avx2)))
+         break;
+      sha::setForcePortable(portable);
+      const bool pass = checkSingle<SHA256>(vs, &Vector::sha256) && checkSingle<SHA512>(vs, &Vector::sha512) &&
+                        checkMany<SHA256>(vs, &Vector::sha256) && checkMany<SHA512>(vs, &Vector::sha512);
+      cout << "\n" << (portable ? "Portable" : "Native") << " (SHA-256 " << (sha::hasShaNi() ? "SHA-NI" : "portable")
+           << ", many: " << SHA256::manyEngine() << " / " << SHA512::manyEngine() << ") FIPS 180-4 known answers: "
+           << (pass ? "PASS" : "FAIL") << endl;
+      throughput<SHA256>("SHA-256", buf);
+      throughput<SHA512>("SHA-512", buf);
+      ok = ok && pass;
+   }
+#if SHA_HAVE_X86
+   // hashMany() prefers SHA-NI over AVX2 lanes for SHA-256, so run the AVX2 lanes directly too
+   if (sha::cpu().avx2 && !wasForced) {
+      std::vector<const uint8_t *> data;
+      std::vector<size_t> len;
+      for (const Vector &v : vs) {
+         data.push_back(reinterpret_cast<const uint8_t *>(v.message.data()));
+         len.push_back(v.message.size());
+      }
+      std::vector<SHA256::Digest> out(vs.size());
+      sha::hashMany256Avx2(data.data(), len.data(), out[0].data(), vs.size());
+      bool pass = true;
+      for (size_t i = 0; i < vs.size(); i++)
+         pass = pass && toHex<SHA256>(out[i]) == vs[i].sha256;
+      cout << "SHA-256 AVX2 x8 lanes known answers: " << (pass ? "PASS" : "FAIL") << endl;
+      ok = ok && pass;
+   }
+#endif
+   sha::setForcePortable(wasForced);
+   return ok;
+}
+
+/*----------------------------------------------------Main----------------------------------------------------*/
+int main(int argc, char *argv[]) {
+   // ./SHA --bench : known-answer checks + throughput (SHA_FORCE_PORTABLE=1 skips SHA-NI and AVX2)
+   if (argc > 1 && std::string(argv[1]) == "--bench")
+      return benchmark() ? 0 : 1;
+
+   std::string message = "The Eagle";
+   cout << "Message: " << message << endl;
+   cout << "SHA-256: " << toHex<SHA256>(SHA256::hash(message)) << endl;
+   cout << "SHA-512: " << toHex<SHA512>(SHA512::hash(message)) << endl;
+
+   std::string slogan = "<------------------------The Eagle------------------------>";
+   cout << endl << std::setw(80) << slogan << endl;
+}
@@ -0,0 +1,382 @@
+/*----------------------------------------------------SHA-256 #️⃣----------------------------------------------------*/
+/* Author      : Hassan (a.k.a. The Eagle 🦅)
+ * Description : SHA-256 (FIPS 180-4) with a streaming interface, plus the SHA-2 core that SHA512.hpp shares:
+ *               - update() any number of times, then final() for the 32-byte digest
+ *               - SHA256::hash() for one-shot input, hashed straight from the caller's memory (no copy
+ *                 except for a partial block)
+ *               - SHA-NI compression picked by CPUID at startup (SHA_FORCE_PORTABLE=1 disables it)
+ *               - SHA256::hashMany(): many independent messages at once, one per SIMD lane
+ *                 (8 with AVX2, 4 with SSE2/NEON vectors)
+ *
+ * Note        : RSA-OAEP (RSA.hpp) uses it for the label hash and MGF1. SHA.cpp is the demo + self-checks.
+ *
+ * Usage       : #include "SHA256.hpp"
+ *
+ * License     : Public Domain / MIT — use it, break it, improve it 👨‍💻
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SHA_HAVE_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#else
+#define SHA_HAVE_X86 0
+#endif
+
+namespace sha {
+
+/*----------------------------------------------------CPU Features----------------------------------------------------*/
+struct CpuFeatures {
+   bool shani = false; // SHA256RNDS2 / SHA256MSG1 / SHA256MSG2 (with SSSE3 + SSE4.1 for the shuffles)
+   bool avx2 = false;  // 256-bit integer vectors (and the OS saves YMM state)
+};
+
+inline CpuFeatures detectCpu() {
+   CpuFeatures f;
+#if SHA_HAVE_X86
+   unsigned int eax, ebx, ecx, edx;
+   if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+      const bool sse = ((ecx >> 9) & 1) && ((ecx >> 19) & 1); // SSSE3, SSE4.1
+      bool osYmm = false;
+      if ((ecx >> 27) & 1) { // OSXSAVE: ask XGETBV whether XMM and YMM state are enabled
+         unsigned int lo, hi;
+         __asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+         osYmm = (lo & 6) == 6;
+      }
+      if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+         f.shani = sse && ((ebx >> 29) & 1);
+         f.avx2 = osYmm && ((ebx >> 5) & 1);
+      }
+   }
+#endif
+   return f;
+}
+inline const CpuFeatures &cpu() {
+   static const CpuFeatures f = detectCpu();
+   return f;
+}
+
+//  Forced-fallback switch: set SHA_FORCE_PORTABLE=1 in the environment, or call setForcePortable(true)
+inline bool &forcePortableFlag() {
+   static bool flag = [] {
+      const char *env = std::getenv("SHA_FORCE_PORTABLE");
+      return env && *env && std::string(env) != "0";
+   }();
+   return flag;
+}
+inline void setForcePortable(bool on) { forcePortableFlag() = on; }
+inline bool hasShaNi() { return cpu().shani && !forcePortableFlag(); }
+inline bool hasAvx2() { return cpu().avx2 && !forcePortableFlag(); }
+
+/*----------------------------------------------------Generic SHA-2 Rounds----------------------------------------------------*/
+// One round function for every width: W is a plain word (one message) or a GCC/Clang vector of words
+// (one message per lane). Traits supply the word type, constants and rotate amounts.
+#define SHA_INLINE __attribute__((always_inline)) inline
+
+template <class Word> inline Word loadBE(const uint8_t *p) {
+   Word w;
+   memcpy(&w, p, sizeof(Word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+   w = sizeof(Word) == 8 ? (Word)__builtin_bswap64(w) : (Word)__builtin_bswap32((uint32_t)w);
+#endif
+   return w;
+}
+template <class Word> inline void storeBE(uint8_t *p, Word w) {
+   for (size_t i = sizeof(Word); i-- > 0; w >>= 8)
+      p[i] = (uint8_t)w;
+}
+
+//  64 or 80 rounds over 16 message words, then the feed-forward. The schedule is expanded up front so the
+//  rounds are a plain chain; eight rounds per pass rename the working variables instead of shifting them.
+//  Everything stays in this one always-inlined body (no vector passed by value), so vector instantiations
+//  compile to whatever the calling function targets.
+#define SHA_ROTR(x, n) (((x) >> (n)) | ((x) << (8 * sizeof(typename Traits::Word) - (n))))
+#define SHA_SIGMA(x, r) (SHA_ROTR(x, r[0]) ^ SHA_ROTR(x, r[1]) ^ SHA_ROTR(x, r[2]))
+#define SHA_GAMMA(x, r) (SHA_ROTR(x, r[0]) ^ SHA_ROTR(x, r[1]) ^ ((x) >> r[2]))
+template <class Traits, class W> SHA_INLINE void compressWords(W s[8], const W m[16]) {
+   W w[Traits::ROUNDS];
+   for (size_t t = 0; t < 16; t++)
+      w[t] = m[t];
+   for (size_t t = 16; t < Traits::ROUNDS; t++)
+      w[t] = SHA_GAMMA(w[t - 2], Traits::GAMMA1) + w[t - 7] + SHA_GAMMA(w[t - 15], Traits::GAMMA0) + w[t - 16];
+   W v[8] = {s[0], s[1], s[2], s[3], s[4], s[5], s[6], s[7]};
+   for (size_t i = 0; i < Traits::ROUNDS; i += 8) {
+#pragma GCC unroll 8
+      for (size_t r = 0; r < 8; r++) {
+         const W &a = v[(8 - r) & 7], &b = v[(9 - r) & 7], &c = v[(10 - r) & 7], &e = v[(12 - r) & 7], &f = v[(13 - r) & 7],
+                 &g = v[(14 - r) & 7];
+         W &d = v[(11 - r) & 7], &h = v[(15 - r) & 7];
+         W t1 = h + SHA_SIGMA(e, Traits::SIGMA1) + ((e & f) ^ (~e & g)) + w[i + r] + Traits::K[i + r];
+         d += t1;
+         h = t1 + SHA_SIGMA(a, Traits::SIGMA0) + ((a & b) ^ (a & c) ^ (b & c));
+      }
+   }
+   for (size_t i = 0; i < 8; i++)
+      s[i] += v[i];
+}
+#undef SHA_GAMMA
+#undef SHA_SIGMA
+#undef SHA_ROTR
+
+//  Portable path: one block at a time, big-endian words loaded straight from data
+template <class Traits> inline void compressPortable(typename Traits::Word state[8], const uint8_t *data, size_t blocks) {
+   using Word = typename Traits::Word;
+   for (; blocks--; data += Traits::BLOCK_SIZE) {
+      Word w[16];
+      for (size_t i = 0; i < 16; i++)
+         w[i] = loadBE<Word>(data + sizeof(Word) * i);
+      compressWords<Traits>(state, w);
+   }
+}
+
+/*----------------------------------------------------Multi-Buffer Lanes----------------------------------------------------*/
+// Each lane of V hashes its own message. A lane that finishes writes its digest and picks up the next
+// message, so short and long messages mix without waiting for the longest one in a group. Blocks come
+// straight from the caller's buffers; only each message's padded tail (1-2 blocks) is built per lane.
+template <class Traits, class V, size_t N>
+SHA_INLINE void hashLanes(const uint8_t *const data[], const size_t len[], uint8_t *out, size_t count) {
+   using Word = typename Traits::Word;
+   constexpr size_t B = Traits::BLOCK_SIZE, WB = sizeof(Word), NONE = ~(size_t)0;
+   struct Lane {
+      size_t msg = NONE, block = 0, full = 0, blocks = 0;
+      uint8_t tail[2 * B];
+   } lanes[N];
+   static const uint8_t idle[B] = {};
+   V state[8];
+   size_t next = 0, active = 0;
+
+   auto start = [&](size_t j) {
+      Lane &l = lanes[j];
+      if (next == count) {
+         l.msg = NONE;
+         return;
+      }
+      l.msg = next++;
+      l.block = 0;
+      l.full = len[l.msg] / B;
+      const size_t rest = len[l.msg] % B, tailBlocks = rest + 1 + Traits::LENGTH_BYTES <= B ? 1 : 2;
+      memcpy(l.tail, data[l.msg] + l.full * B, rest);
+      memset(l.tail + rest, 0, tailBlocks * B - rest);
+      l.tail[rest] = 0x80;
+      Traits::putLength(l.tail + tailBlocks * B, len[l.msg]);
+      l.blocks = l.full + tailBlocks;
+      for (size_t i = 0; i < 8; i++)
+         state[i][j] = Traits::IV[i];
+      active++;
+   };
+   for (size_t i = 0; i < 8; i++)
+      state[i] = V{} + Traits::IV[i];
+   for (size_t j = 0; j < N; j++)
+      start(j);
+
+   while (active) {
+      alignas(64) Word words[16][N];
+      for (size_t j = 0; j < N; j++) {
+         const Lane &l = lanes[j];
+         const uint8_t *p = l.msg == NONE ? idle : l.block < l.full ? data[l.msg] + l.block * B : l.tail + (l.block - l.full) * B;
+         for (size_t i = 0; i < 16; i++)
+            words[i][j] = loadBE<Word>(p + WB * i);
+      }
+      V w[16];
+      memcpy(w, words, sizeof(w));
+      compressWords<Traits>(state, w);
+      for (size_t j = 0; j < N; j++) {
+         Lane &l = lanes[j];
+         if (l.msg == NONE || ++l.block < l.blocks)
+            continue;
+         for (size_t i = 0; i < Traits::DIGEST_SIZE / WB; i++)
+            storeBE<Word>(out + l.msg * Traits::DIGEST_SIZE + WB * i, state[i][j]);
+         active--;
+         start(j);
+      }
+   }
+}
+
+/*----------------------------------------------------Streaming Hash----------------------------------------------------*/
+// update() buffers at most one partial block; whole blocks in the input go to Traits::compress in one call.
+template <class Traits> class Hash {
+ public:
+   using Word = typename Traits::Word;
+   static constexpr size_t DIGEST_SIZE = Traits::DIGEST_SIZE;
+   static constexpr size_t BLOCK_SIZE = Traits::BLOCK_SIZE;
+   using Digest = std::array<uint8_t, DIGEST_SIZE>;
+
+   Hash() { reset(); }
+
+   void reset() {
+      memcpy(state, Traits::IV, sizeof(state));
+      totalLen = 0;
+      bufferLen = 0;
+   }
+
+   Hash &update(const uint8_t *data, size_t len) {
+      totalLen += len;
+      if (bufferLen) {
+         size_t take = len < BLOCK_SIZE - bufferLen ? len : BLOCK_SIZE - bufferLen;
+         memcpy(buffer + bufferLen, data, take);
+         bufferLen += take;
+         data += take;
+         len -= take;
+         if (bufferLen < BLOCK_SIZE)
+            return *this;
+         Traits::compress(state, buffer, 1);
+         bufferLen = 0;
+      }
+      if (len >= BLOCK_SIZE) {
+         Traits::compress(state, data, len / BLOCK_SIZE);
+         data += len / BLOCK_SIZE * BLOCK_SIZE;
+         len %= BLOCK_SIZE;
+      }
+      memcpy(buffer, data, len);
+      bufferLen = len;
+      return *this;
+   }
+   Hash &update(const std::string &s) { return update(reinterpret_cast<const uint8_t *>(s.data()), s.size()); }
+
+   //  Pads, writes the digest and resets, so the object can hash the next message
+   void final(uint8_t out[DIGEST_SIZE]) {
+      uint8_t pad[BLOCK_SIZE * 2] = {0x80};
+      size_t padLen = (bufferLen + 1 + Traits::LENGTH_BYTES <= BLOCK_SIZE ? BLOCK_SIZE : 2 * BLOCK_SIZE) - bufferLen;
+      Traits::putLength(pad + padLen, totalLen);
+      update(pad, padLen);
+      for (size_t i = 0; i < DIGEST_SIZE / sizeof(Word); i++)
+         storeBE<Word>(out + sizeof(Word) * i, state[i]);
+      reset();
+   }
+   Digest final() {
+      Digest d;
+      final(d.data());
+      return d;
+   }
+
+   static Digest hash(const uint8_t *data, size_t len) { return Hash().update(data, len).final(); }
+   static Digest hash(const std::string &s) { return Hash().update(s).final(); }
+
+   //  count independent messages (data[i], len[i]) into out[i]: SIMD lanes, or one at a time when the
+   //  single-message path is faster (Traits::hashMany decides)
+   static void hashMany(const uint8_t *const data[], const size_t len[], Digest out[], size_t count) {
+      static_assert(sizeof(Digest) == DIGEST_SIZE, "digests must be packed back to back");
+      Traits::hashMany(data, len, out->data(), count);
+   }
+
+   //  Name of the path hashMany() takes on this machine
+   static const char *manyEngine() { return Traits::manyEngine(); }
+
+ private:
+   Word state[8];
+   uint64_t totalLen;
+   uint8_t buffer[BLOCK_SIZE];
+   size_t bufferLen;
+};
+
+/*----------------------------------------------------SHA-256----------------------------------------------------*/
+#if SHA_HAVE_X86
+#define SHA_TARGET_SHANI __attribute__((target("sha,sse4.1,ssse3")))
+#define SHA_TARGET_AVX2 __attribute__((target("avx2")))
+
+//  Intel SHA extensions: the state lives as ABEF / CDGH, each SHA256RNDS2 does two rounds and
+//  MSG1 / MSG2 compute the message schedule four words at a time
+SHA_TARGET_SHANI inline void compress256ShaNi(uint32_t state[8], const uint8_t *data, size_t blocks, const uint32_t *K) {
+   const __m128i MASK = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+   __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)state), 0xB1);          // CDAB
+   __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(state + 4)), 0x1B); // EFGH
+   __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);                                        // ABEF
+   state1 = _mm_blend_epi16(state1, tmp, 0xF0);                                             // CDGH
+
+   for (; blocks--; data += 64) {
+      const __m128i abef = state0, cdgh = state1;
+      __m128i msg[4];
+#pragma GCC unroll 16
+      for (int g = 0; g < 16; g++) {
+         if (g < 4)
+            msg[g] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16 * g)), MASK);
+         __m128i m = _mm_add_epi32(msg[g & 3], _mm_loadu_si128((const __m128i *)(K + 4 * g)));
+         state1 = _mm_sha256rnds2_epu32(state1, state0, m);
+         if (g >= 3 && g <= 14) {
+            __m128i &nx = msg[(g + 1) & 3];
+            nx = _mm_add_epi32(nx, _mm_alignr_epi8(msg[g & 3], msg[(g - 1) & 3], 4));
+            nx = _mm_sha256msg2_epu32(nx, msg[g & 3]);
+         }
+         state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(m, 0x0E));
+         if (g >= 1 && g <= 12)
+            msg[(g - 1) & 3] = _mm_sha256msg1_epu32(msg[(g - 1) & 3], msg[g & 3]);
+      }
+      state0 = _mm_add_epi32(state0, abef);
+      state1 = _mm_add_epi32(state1, cdgh);
+   }
+
+   tmp = _mm_shuffle_epi32(state0, 0x1B);       // FEBA
+   state1 = _mm_shuffle_epi32(state1, 0xB1);    // DCHG
+   state0 = _mm_blend_epi16(tmp, state1, 0xF0); // DCBA
+   state1 = _mm_alignr_epi8(state1, tmp, 8);    // HGFE
+   _mm_storeu_si128((__m128i *)state, state0);
+   _mm_storeu_si128((__m128i *)(state + 4), state1);
+}
+#endif
+
+typedef uint32_t Lanes32x4 __attribute__((vector_size(16))); // 4 messages (SSE2 / NEON)
+typedef uint32_t Lanes32x8 __attribute__((vector_size(32))); // 8 messages (AVX2)
+
+struct Sha256Traits {
+   using Word = uint32_t;
+   static constexpr size_t DIGEST_SIZE = 32, BLOCK_SIZE = 64, ROUNDS = 64, LENGTH_BYTES = 8;
+   alignas(16) static constexpr Word K[64] = {
+       0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be,
+       0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa,
+       0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85,
+       0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+       0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f,
+       0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+   static constexpr Word IV[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+   //  Rotate amounts for Σ0, Σ1 (three rotations) and σ0, σ1 (two rotations and a shift)
+   static constexpr int SIGMA0[3] = {2, 13, 22}, SIGMA1[3] = {6, 11, 25}, GAMMA0[3] = {7, 18, 3}, GAMMA1[3] = {17, 19, 10};
+
+   //  Message length in bits, big-endian, in the last 8 bytes of the final block (end points past it)
+   static void putLength(uint8_t *end, uint64_t bytes) { storeBE<uint64_t>(end - 8, bytes * 8); }
+
+   static void compress(Word state[8], const uint8_t *data, size_t blocks) {
+#if SHA_HAVE_X86
+      if (hasShaNi())
+         return compress256ShaNi(state, data, blocks, K);
+#endif
+      compressPortable<Sha256Traits>(state, data, blocks);
+   }
+
+   static void hashMany(const uint8_t *const data[], const size_t len[], uint8_t *out, size_t count);
+   static const char *manyEngine();
+};
+
+#if SHA_HAVE_X86
+SHA_TARGET_AVX2 inline void hashMany256Avx2(const uint8_t *const data[], const size_t len[], uint8_t *out, size_t count) {
+   hashLanes<Sha256Traits, Lanes32x8, 8>(data, len, out, count);
+}
+#endif
+
+//  SHA-NI finishes a block in fewer cycles than eight AVX2 lanes share one, so it wins when present
+inline void Sha256Traits::hashMany(const uint8_t *const data[], const size_t len[], uint8_t *out, size_t count) {
+#if SHA_HAVE_X86
+   if (hasShaNi()) {
+      for (size_t i = 0; i < count; i++)
+         Hash<Sha256Traits>().update(data[i], len[i]).final(out + i * DIGEST_SIZE);
+      return;
+   }
+   if (hasAvx2())
+      return hashMany256Avx2(data, len, out, count);
+#endif
+   hashLanes<Sha256Traits, Lanes32x4, 4>(data, len, out, count);
+}
+inline const char *Sha256Traits::manyEngine() { return hasShaNi() ? "shani" : hasAvx2() ? "avx2x8" : "simdx4"; }
+
+} // namespace sha
+
+using SHA256 = sha::Hash<sha::Sha256Traits>;
@@ -0,0 +1,706 @@
+/*----------------------------------------------------Fixed-Width Big Integers 🧮----------------------------------------------------*/
+/* Author      : Hassan (a.k.a. The Eagle 🦅)
+ * Description : Unsigned integers of a fixed, compile-time width (2048/3072/4096-bit and so on) for RSA:
+ *               - 64-bit limbs, least significant first
+ *               - Add/subtract/compare/shift, schoolbook multiply, binary long division
+ *               - Binary gcd and modular inverse
+ *               - Hex, big-endian byte and decimal conversion
+ *               - Montgomery multiplication (CIOS) with sliding-window exponentiation, and a fixed-window one for secrets
+ *               - Four-lane AVX2 Montgomery for batches of exponentiations under one modulus
+ *
+ * Note        : Montgomery::powSecret (fixed windows, masked table reads) and the Montgomery products, mod,
+ *               reduce and subMod it builds on do not branch or index on the data; RSA private keys and DH
+ *               private values go through them. Everything else (pow's sliding window, division, gcd, inverse,
+ *               comparisons) is variable time and is only meant for public values and key generation.
+ *
+ * Usage       : #include "BigNum.hpp" — RSA.hpp builds on it
+ *
+ * License     : Public Domain / MIT — use it, break it, improve it 👨‍💻
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#if defined(__GNUC__) && defined(__x86_64__)
+#define BN_HAVE_AVX2 1
+#include <immintrin.h>
+#define BN_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define BN_HAVE_AVX2 0
+#endif
+
+namespace bn {
+
+using u128 = unsigned __int128;
+
+/*----------------------------------------------------UInt<Bits>----------------------------------------------------*/
+// Plain value type: copying is a memcpy, arithmetic wraps modulo 2^Bits like the built-in unsigned types.
+template <size_t Bits> struct UInt {
+   static_assert(Bits % 64 == 0 && Bits > 0, "UInt width must be a whole number of 64-bit limbs");
+   static constexpr size_t LIMBS = Bits / 64;
+
+   uint64_t limb[LIMBS] = {};
+
+   UInt() = default;
+   UInt(uint64_t v) { limb[0] = v; }
+   //  Zero-extends or truncates another width
+   template <size_t Other> explicit UInt(const UInt<Other> &o) {
+      for (size_t i = 0; i < LIMBS && i < UInt<Other>::LIMBS; i++)
+         limb[i] = o.limb[i];
+   }
+
+   /*----------------------------------------------------Conversion----------------------------------------------------*/
+   static UInt fromHex(const std::string &hex) {
+      UInt r;
+      size_t bit = 0;
+      for (size_t i = hex.size(); i-- > 0;) {
+         char c = hex[i];
+         int v = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+         if (v < 0)
+            throw std::invalid_argument("Bad hex digit in big integer!");
+         if (v && bit >= Bits)
+            throw std::invalid_argument("Hex value too large for big integer!");
+         if (bit < Bits)
+            r.limb[bit / 64] |= (uint64_t)v << (bit % 64);
+         bit += 4;
+      }
+      return r;
+   }
+   //  Big-endian bytes, as in RSA (I2OSP / OS2IP)
+   static UInt fromBytes(const uint8_t *in, size_t len) {
+      UInt r;
+      for (size_t i = 0; i < len; i++) {
+         size_t pos = len - 1 - i; // byte index from the least significant end
+         if (pos >= Bits / 8) {
+            if (in[i])
+               throw std::invalid_argument("Byte string too large for big integer!");
+            continue;
+         }
+         r.limb[pos / 8] |= (uint64_t)in[i] << (8 * (pos % 8));
+      }
+      return r;
+   }
+   void toBytes(uint8_t *out, size_t len) const {
+      if (len * 8 < bitLength())
+         throw std::invalid_argument("Big integer does not fit the output length!");
+      for (size_t i = 0; i < len; i++) {
+         size_t pos = len - 1 - i;
+         out[i] = pos < Bits / 8 ? (uint8_t)(limb[pos / 8] >> (8 * (pos % 8))) : 0;
+      }
+   }
+   std::string toHex() const {
+      static const char digits[] = "0123456789abcdef";
+      std::string s;
+      for (size_t i = Bits / 4; i-- > 0;) {
+         unsigned v = (limb[i / 16] >> (4 * (i % 16))) & 0xF;
+         if (v || !s.empty())
+            s += digits[v];
+      }
+      return s.empty() ? "0" : s;
+   }
+   std::string toDecimal() const {
+      UInt t = *this;
+      std::string s;
+      do {
+         uint64_t chunk = t.divSmall(10000000000000000000ULL); // 10^19: 19 digits per pass
+         for (int d = 0; d < 19 && (chunk || !t.isZero()); d++, chunk /= 10)
+            s.insert(s.begin(), (char)('0' + chunk % 10));
+      } while (!t.isZero());
+      return s.empty() ? "0" : s;
+   }
+   uint64_t low64() const { return limb[0]; }
+
+   /*----------------------------------------------------Bits & Comparison----------------------------------------------------*/
+   bool isZero() const {
+      uint64_t acc = 0;
+      for (size_t i = 0; i < LIMBS; i++)
+         acc |= limb[i];
+      return acc == 0;
+   }
+   bool isOdd() const { return limb[0] & 1; }
+   bool bit(size_t i) const { return (limb[i / 64] >> (i % 64)) & 1; }
+   void setBit(size_t i) { limb[i / 64] |= 1ULL << (i % 64); }
+   size_t bitLength() const {
+      for (size_t i = LIMBS; i-- > 0;)
+         if (limb[i])
+            return i * 64 + 64 - __builtin_clzll(limb[i]);
+      return 0;
+   }
+   static int compare(const UInt &a, const UInt &b) {
+      for (size_t i = LIMBS; i-- > 0;)
+         if (a.limb[i] != b.limb[i])
+            return a.limb[i] < b.limb[i] ? -1 : 1;
+      return 0;
+   }
+   friend bool operator==(const UInt &a, const UInt &b) { return compare(a, b) == 0; }
+   friend bool operator!=(const UInt &a, const UInt &b) { return compare(a, b) != 0; }
+   friend bool operator<(const UInt &a, const UInt &b) { return compare(a, b) < 0; }
+   friend bool operator>(const UInt &a, const UInt &b) { return compare(a, b) > 0; }
+   friend bool operator<=(const UInt &a, const UInt &b) { return compare(a, b) <= 0; }
+   friend bool operator>=(const UInt &a, const UInt &b) { return compare(a, b) >= 0; }
+
+   /*----------------------------------------------------Add / Subtract / Shift----------------------------------------------------*/
+   //  this += b, returns the carry out of the top limb
+   uint64_t addTo(const UInt &b) {
+      uint64_t carry = 0;
+      for (size_t i = 0; i < LIMBS; i++) {
+         u128 s = (u128)limb[i] + b.limb[i] + carry;
+         limb[i] = (uint64_t)s;
+         carry = (uint64_t)(s >> 64);
+      }
+      return carry;
+   }
+   //  this -= b, returns the borrow out of the top limb
+   uint64_t subFrom(const UInt &b) {
+      uint64_t borrow = 0;
+      for (size_t i = 0; i < LIMBS; i++) {
+         u128 d = (u128)limb[i] - b.limb[i] - borrow;
+         limb[i] = (uint64_t)d;
+         borrow = (uint64_t)(d >> 64) & 1;
+      }
+      return borrow;
+   }
+   friend UInt operator+(UInt a, const UInt &b) {
+      a.addTo(b);
+      return a;
+   }
+   friend UInt operator-(UInt a, const UInt &b) {
+      a.subFrom(b);
+      return a;
+   }
+   UInt &operator+=(const UInt &b) {
+      addTo(b);
+      return *this;
+   }
+   UInt &operator-=(const UInt &b) {
+      subFrom(b);
+      return *this;
+   }
+   friend UInt operator<<(const UInt &a, size_t n) {
+      UInt r;
+      size_t w = n / 64, s = n % 64;
+      for (size_t i = LIMBS; i-- > w;) {
+         r.limb[i] = a.limb[i - w] << s;
+         if (s && i > w)
+            r.limb[i] |= a.limb[i - w - 1] >> (64 - s);
+      }
+      return r;
+   }
+   friend UInt operator>>(const UInt &a, size_t n) {
+      UInt r;
+      size_t w = n / 64, s = n % 64;
+      for (size_t i = 0; i + w < LIMBS; i++) {
+         r.limb[i] = a.limb[i + w] >> s;
+         if (s && i + w + 1 < LIMBS)
+            r.limb[i] |= a.limb[i + w + 1] << (64 - s);
+      }
+      return r;
+   }
+
+   /*----------------------------------------------------Multiply / Divide----------------------------------------------------*/
+   //  Full double-width product (schoolbook)
+   UInt<2 * Bits> mulWide(const UInt &b) const {
+      UInt<2 * Bits> r;
+      for (size_t i = 0; i < LIMBS; i++) {
+         uint64_t carry = 0;
+         for (size_t j = 0; j < LIMBS; j++) {
+            u128 t = (u128)limb[i] * b.limb[j] + r.limb[i + j] + carry;
+            r.limb[i + j] = (uint64_t)t;
+            carry = (uint64_t)(t >> 64);
+         }
+         r.limb[i + LIMBS] = carry;
+      }
+      return r;
+   }
+   friend UInt operator*(const UInt &a, const UInt &b) { return UInt(a.mulWide(b)); }
+
+   //  this /= d, returns the remainder (d != 0)
+   uint64_t divSmall(uint64_t d) {
+      u128 rem = 0;
+      for (size_t i = LIMBS; i-- > 0;) {
+         u128 cur = (rem << 64) | limb[i];
+         limb[i] = (uint64_t)(cur / d);
+         rem = cur % d;
+      }
+      return (uint64_t)rem;
+   }
+   //  Binary long division; one shift-subtract per quotient bit
+   static void divMod(const UInt &a, const UInt &b, UInt &quot, UInt &rem) {
+      if (b.isZero())
+         throw std::invalid_argument("Big integer division by zero!");
+      quot = UInt();
+      rem = UInt();
+      for (size_t i = a.bitLength(); i-- > 0;) {
+         uint64_t top = rem.limb[LIMBS - 1] >> 63; // bit shifted out of rem (only when b uses the top bit)
+         rem = rem << 1;
+         rem.limb[0] |= (uint64_t)a.bit(i);
+         if (top || rem >= b) {
+            rem.subFrom(b);
+            quot.setBit(i);
+         }
+      }
+   }
+   friend UInt operator/(const UInt &a, const UInt &b) {
+      UInt q, r;
+      divMod(a, b, q, r);
+      return q;
+   }
+   friend UInt operator%(const UInt &a, const UInt &b) {
+      UInt q, r;
+      divMod(a, b, q, r);
+      return r;
+   }
+
+   friend std::ostream &operator<<(std::ostream &os, const UInt &v) { return os << v.toDecimal(); }
+};
+
+/*----------------------------------------------------GCD & Modular Inverse----------------------------------------------------*/
+// Binary algorithms: shifts and subtractions only, no long division inside the loops.
+
+//  Stein's binary gcd
+template <size_t Bits> UInt<Bits> gcd(UInt<Bits> a, UInt<Bits> b) {
+   if (a.isZero())
+      return b;
+   if (b.isZero())
+      return a;
+   size_t shift = 0;
+   while (!a.isOdd() && !b.isOdd()) {
+      a = a >> 1;
+      b = b >> 1;
+      shift++;
+   }
+   while (!a.isOdd())
+      a = a >> 1;
+   do {
+      while (!b.isOdd())
+         b = b >> 1;
+      if (a > b)
+         std::swap(a, b);
+      b.subFrom(a);
+   } while (!b.isZero());
+   return a << shift;
+}
+
+//  x / 2 mod m for odd m (adds m first when x is odd; the carry becomes the top bit)
+template <size_t Bits> void halveMod(UInt<Bits> &x, const UInt<Bits> &m) {
+   uint64_t carry = x.isOdd() ? x.addTo(m) : 0;
+   x = x >> 1;
+   x.limb[UInt<Bits>::LIMBS - 1] |= carry << 63;
+}
+
+//  a^-1 mod m for odd m > 1 (binary extended Euclid, HAC 14.61 with the coefficients kept in [0, m))
+template <size_t Bits> UInt<Bits> inverseModOdd(const UInt<Bits> &a, const UInt<Bits> &m) {
+   using Num = UInt<Bits>;
+   if (!m.isOdd() || m <= Num(1))
+      throw std::invalid_argument("Binary inverse needs an odd modulus greater than 1!");
+   Num u = a % m, v = m, x1 = Num(1), x2 = Num(0);
+   while (u != Num(1) && v != Num(1)) {
+      if (u.isZero())
+         throw std::invalid_argument("Value has no inverse modulo m!");
+      while (!u.isOdd()) {
+         u = u >> 1;
+         halveMod(x1, m);
+      }
+      while (!v.isOdd()) {
+         v = v >> 1;
+         halveMod(x2, m);
+      }
+      if (u >= v) {
+         u.subFrom(v);
+         if (x1.subFrom(x2))
+            x1.addTo(m);
+      } else {
+         v.subFrom(u);
+         if (x2.subFrom(x1))
+            x2.addTo(m);
+      }
+   }
+   return u == Num(1) ? x1 : x2;
+}
+
+//  a^-1 mod m; an even m needs an odd a (RSA: d = e^-1 mod lambda(n)). For even m, with y = m^-1 mod a,
+//  (1 + m * (a - y)) is divisible by a and the quotient is the inverse
+template <size_t Bits> UInt<Bits> inverseMod(const UInt<Bits> &a, const UInt<Bits> &m) {
+   using Num = UInt<Bits>;
+   using Wide = UInt<2 * Bits>;
+   if (m.isOdd())
+      return inverseModOdd(a, m);
+   if (!a.isOdd())
+      throw std::invalid_argument("Value has no inverse modulo m!");
+   if (a == Num(1))
+      return Num(1);
+   Num y = inverseModOdd(m % a, a);
+   Wide t = m.mulWide(a - y);
+   t.addTo(Wide(1));
+   return Num(t / Wide(a));
+}
+
+/*----------------------------------------------------Montgomery Arithmetic----------------------------------------------------*/
+// Residues mod an odd n are kept as aR mod n (R = 2^Bits), so a modular product costs one interleaved
+// multiply-and-reduce (CIOS) pass instead of a full product plus a long division.
+template <size_t Bits> class Montgomery {
+ public:
+   using Num = UInt<Bits>;
+   static constexpr size_t LIMBS = Num::LIMBS;
+
+   //  n: odd modulus, built once per key and reused for every exponentiation
+   explicit Montgomery(const Num &n) : n(n) {
+      if (!n.isOdd() || n == Num(1))
+         throw std::invalid_argument("Montgomery modulus must be odd and greater than 1!");
+      // -n^-1 mod 2^64 by Newton iteration: each step doubles the number of correct low bits
+      uint64_t inv = 1;
+      for (int i = 0; i < 6; i++)
+         inv *= 2 - n.limb[0] * inv;
+      n0 = 0 - inv;
+      // R mod n, then R^2 mod n by Bits modular doublings
+      Num r = Num(1);
+      for (size_t i = 0; i < 2 * Bits; i++) {
+         uint64_t carry = r.limb[LIMBS - 1] >> 63;
+         r = r << 1;
+         if (carry || r >= n)
+            r.subFrom(n);
+         if (i + 1 == Bits)
+            one = r;
+      }
+      r2 = r;
+   }
+
+   const Num &modulus() const { return n; }
+
+   //  a * b * R^-1 mod n (a, b < n)
+   Num mul(const Num &a, const Num &b) const {
+      uint64_t t[LIMBS + 2] = {0};
+      for (size_t i = 0; i < LIMBS; i++) {
+         // t += a * b[i]
+         uint64_t carry = 0;
+         for (size_t j = 0; j < LIMBS; j++) {
+            u128 s = (u128)a.limb[j] * b.limb[i] + t[j] + carry;
+            t[j] = (uint64_t)s;
+            carry = (uint64_t)(s >> 64);
+         }
+         u128 s = (u128)t[LIMBS] + carry;
+         t[LIMBS] = (uint64_t)s;
+         t[LIMBS + 1] = (uint64_t)(s >> 64);
+         // t = (t + m * n) / 2^64, with m chosen so the low limb cancels
+         uint64_t m = t[0] * n0;
+         s = (u128)m * n.limb[0] + t[0];
+         carry = (uint64_t)(s >> 64);
+         for (size_t j = 1; j < LIMBS; j++) {
+            s = (u128)m * n.limb[j] + t[j] + carry;
+            t[j - 1] = (uint64_t)s;
+            carry = (uint64_t)(s >> 64);
+         }
+         s = (u128)t[LIMBS] + carry;
+         t[LIMBS - 1] = (uint64_t)s;
+         t[LIMBS] = t[LIMBS + 1] + (uint64_t)(s >> 64);
+      }
+      return subtractOnce(t, t[LIMBS]);
+   }
+   //  a mod n; one masked subtraction when n uses the top bit (every RSA modulus and prime does), else
+   //  a * R * R^-1 as two products (a < R, so the first one still ends below 2n)
+   Num mod(const Num &a) const { return n.bit(Bits - 1) ? subtractOnce(a.limb, 0) : mul(mul(a, r2), Num(1)); }
+   //  x mod n for a double-width x = hi * R + lo, via hi * R = toMont(hi); no long division
+   Num reduce(const UInt<2 * Bits> &x) const {
+      Num r = toMont(Num(x >> Bits)), lo = mod(Num(x));
+      uint64_t carry = r.addTo(lo);
+      return subtractOnce(r.limb, carry);
+   }
+   //  (a - b) mod n for a, b < n; n is added back by mask, not by a branch on the borrow
+   Num subMod(const Num &a, const Num &b) const {
+      Num r = a;
+      const uint64_t mask = 0 - r.subFrom(b);
+      uint64_t carry = 0;
+      for (size_t i = 0; i < LIMBS; i++) {
+         u128 s = (u128)r.limb[i] + (n.limb[i] & mask) + carry;
+         r.limb[i] = (uint64_t)s;
+         carry = (uint64_t)(s >> 64);
+      }
+      return r;
+   }
+   Num toMont(const Num &a) const { return mul(mod(a), r2); }
+   Num fromMont(const Num &a) const { return mul(a, Num(1)); }
+
+   //  base^exp mod n, left-to-right sliding window over odd powers
+   Num pow(const Num &base, const Num &exp) const {
+      size_t bits = exp.bitLength();
+      if (bits == 0)
+         return n == Num(1) ? Num() : Num(1);
+      const int w = bits > 768 ? 6 : bits > 256 ? 5 : bits > 64 ? 4 : bits > 16 ? 3 : 1;
+      Num table[1 << 5]; // base^1, base^3, ..., base^(2^w - 1) in Montgomery form
+      table[0] = toMont(base);
+      Num sq = mul(table[0], table[0]);
+      for (int i = 1; i < (1 << (w - 1)); i++)
+         table[i] = mul(table[i - 1], sq);
+
+      Num acc = one;
+      size_t i = bits;
+      while (i > 0) {
+         if (!exp.bit(i - 1)) {
+            acc = mul(acc, acc);
+            i--;
+            continue;
+         }
+         // Longest window of at most w bits that starts at bit i-1 and ends on a set bit
+         size_t len = std::min<size_t>(w, i);
+         while (!exp.bit(i - len))
+            len--;
+         unsigned value = 0;
+         for (size_t k = 0; k < len; k++)
+            value = (value << 1) | exp.bit(i - 1 - k);
+         for (size_t k = 0; k < len; k++)
+            acc = mul(acc, acc);
+         acc = mul(acc, table[value >> 1]);
+         i -= len;
+      }
+      return fromMont(acc);
+   }
+
+   //  base^exp mod n for a secret exponent (RSA d, dP, dQ; DH private values) of at most expBits bits.
+   //  Fixed windows of W bits over all expBits, zero windows included, so the squarings and multiplies
+   //  come in the same order for every exponent; each multiply scans the whole table and keeps its entry
+   //  by mask, so the memory touched does not depend on the window either. pow() stays for public exponents.
+   Num powSecret(const Num &base, const Num &exp, size_t expBits = Bits) const {
+      constexpr unsigned W = Bits > 512 ? 5 : 4;
+      expBits = std::min(expBits, Bits);
+      Num table[1 << W]; // base^0 .. base^(2^W - 1) in Montgomery form
+      table[0] = one;
+      table[1] = toMont(base);
+      for (size_t i = 2; i < (1u << W); i++)
+         table[i] = mul(table[i - 1], table[1]);
+
+      Num acc = one;
+      for (size_t i = (expBits + W - 1) / W * W; i > 0; i -= W) {
+         unsigned value = 0;
+         for (size_t k = i; k-- > i - W;)
+            value = (value << 1) | (k < Bits && exp.bit(k));
+         for (unsigned k = 0; k < W; k++)
+            acc = mul(acc, acc);
+         acc = mul(acc, select(table, 1u << W, value));
+      }
+      return fromMont(acc);
+   }
+
+   //  table[index] for a secret index: every entry is read and the wanted one kept by mask
+   static Num select(const Num *table, size_t count, size_t index) {
+      Num r;
+      for (size_t j = 0; j < count; j++) {
+         const uint64_t mask = 0 - (((uint64_t)(j ^ index) - 1) >> 63);
+         for (size_t i = 0; i < LIMBS; i++)
+            r.limb[i] |= table[j].limb[i] & mask;
+      }
+      return r;
+   }
+
+ private:
+   Num n, r2, one; // modulus, R^2 mod n, R mod n (Montgomery form of 1)
+   uint64_t n0;    // -n^-1 mod 2^64
+
+   //  t - n if top:t >= n, else t (top:t < 2n); chosen by mask so the branch does not depend on t
+   Num subtractOnce(const uint64_t *t, uint64_t top) const {
+      Num r, d;
+      uint64_t borrow = 0;
+      for (size_t i = 0; i < LIMBS; i++) {
+         u128 s = (u128)t[i] - n.limb[i] - borrow;
+         d.limb[i] = (uint64_t)s;
+         borrow = (uint64_t)(s >> 64) & 1;
+      }
+      const uint64_t keep = 0 - ((top | (borrow ^ 1)) & 1);
+      for (size_t i = 0; i < LIMBS; i++)
+         r.limb[i] = (d.limb[i] & keep) | (t[i] & ~keep);
+      return r;
+   }
+};
+
+/*----------------------------------------------------Four-Lane Montgomery (AVX2)----------------------------------------------------*/
+//  AVX2 is used when the compiler can target it and the CPU has it; BN_FORCE_PORTABLE=1 or setForcePortable(true)
+//  keeps everything on the scalar path (for comparisons and for hosts that misreport it)
+inline bool &forcePortableFlag() {
+   static bool flag = [] {
+      const char *env = std::getenv("BN_FORCE_PORTABLE");
+      return env && *env && std::string(env) != "0";
+   }();
+   return flag;
+}
+inline void setForcePortable(bool on) { forcePortableFlag() = on; }
+inline bool hasAvx2() {
+#if BN_HAVE_AVX2
+   static const bool cpu = __builtin_cpu_supports("avx2");
+   return cpu && !forcePortableFlag();
+#else
+   return false;
+#endif
+}
+
+// Four exponentiations mod the same n with the same exponent, one per 64-bit lane. Numbers are split into
+// RADIX-bit limbs so a full row of 32x32-bit products (VPMULUDQ) can pile up in each 64-bit lane without carry
+// handling; carries are resolved once per multiplication. Values stay below 2n between steps (almost-Montgomery,
+// which needs 4n < 2^(RADIX * L)), and the single conditional subtraction happens on the way out.
+template <size_t Bits> class MontgomeryX4 {
+ public:
+   using Num = UInt<Bits>;
+   static constexpr size_t LANES = 4;
+
+ private:
+   //  Widest radix whose column sums (2L products of 2 * RADIX bits, plus a carry) still fit 64 bits
+   static constexpr size_t limbsFor(size_t radix) { return (Bits + 2 + radix - 1) / radix; }
+   static constexpr size_t pickRadix() {
+      size_t r = 32;
+      while (2 * limbsFor(r) + 1 > (1ULL << (64 - 2 * r)))
+         r--;
+      return r;
+   }
+
+ public:
+   static constexpr size_t RADIX = pickRadix();
+   static constexpr size_t L = limbsFor(RADIX);
+
+   //  Shares the scalar context's modulus and uses it once for R^2 mod n (R = 2^(RADIX * L))
+   explicit MontgomeryX4(const Montgomery<Bits> &scalar) : n(scalar.modulus()) {
+      uint64_t inv = 1;
+      for (int i = 0; i < 6; i++)
+         inv *= 2 - n.limb[0] * inv;
+      k0 = (0 - inv) & MASK;
+      split(n, nLimbs);
+      split(scalar.pow(Num(2), Num(2 * RADIX * L)), r2Limbs);
+   }
+
+   const Num &modulus() const { return n; }
+
+   //  out[i] = base[i]^exp mod n for the first `used` bases (each < n; unused lanes are don't-care);
+   //  without AVX2 the scalar context does them one by one
+   void pow(const Num base[LANES], const Num &exp, Num out[LANES], const Montgomery<Bits> &scalar, size_t used = LANES) const {
+#if BN_HAVE_AVX2
+      if (hasAvx2()) {
+         powAvx2(base, exp, out);
+         return;
+      }
+#endif
+      for (size_t i = 0; i < used && i < LANES; i++)
+         out[i] = scalar.pow(base[i], exp);
+   }
+
+ private:
+   static constexpr uint64_t MASK = (1ULL << RADIX) - 1;
+   Num n;
+   uint64_t k0;                         // -n^-1 mod 2^RADIX
+   uint64_t nLimbs[L], r2Limbs[L];      // n and R^2 mod n, RADIX bits per limb
+
+   static void split(const Num &x, uint64_t *out) {
+      for (size_t j = 0; j < L; j++) {
+         size_t bit = j * RADIX, w = bit / 64, s = bit % 64;
+         uint64_t v = w < Num::LIMBS ? x.limb[w] >> s : 0;
+         if (s + RADIX > 64 && w + 1 < Num::LIMBS)
+            v |= x.limb[w + 1] << (64 - s);
+         out[j] = v & MASK;
+      }
+   }
+   //  Limbs (each < 2^RADIX) back to an integer; the value is at most n here
+   static UInt<Bits + 64> join(const uint64_t *in, size_t stride) {
+      UInt<Bits + 64> r;
+      for (size_t j = 0; j < L; j++) {
+         uint64_t v = in[j * stride];
+         size_t bit = j * RADIX, w = bit / 64, s = bit % 64;
+         if (w < UInt<Bits + 64>::LIMBS)
+            r.limb[w] |= v << s;
+         if (s + RADIX > 64 && w + 1 < UInt<Bits + 64>::LIMBS)
+            r.limb[w + 1] |= v >> (64 - s);
+      }
+      return r;
+   }
+
+#if BN_HAVE_AVX2
+   //  out = a * b / R mod n (< 2n) for all four lanes; a, b < 2n
+   BN_TARGET_AVX2 void mul(const __m256i *a, const __m256i *b, __m256i *out) const {
+      __m256i t[2 * L + 1];
+      for (size_t i = 0; i < 2 * L + 1; i++)
+         t[i] = _mm256_setzero_si256();
+      const __m256i mask = _mm256_set1_epi64x(MASK), k = _mm256_set1_epi64x(k0);
+      for (size_t i = 0; i < L; i++) {
+         const __m256i bi = b[i];
+         __m256i *ti = t + i;
+         // Low column first: it decides m, and m * n[0] clears its low RADIX bits
+         ti[0] = _mm256_add_epi64(ti[0], _mm256_mul_epu32(a[0], bi));
+         const __m256i m = _mm256_and_si256(_mm256_mul_epu32(ti[0], k), mask);
+         ti[0] = _mm256_add_epi64(ti[0], _mm256_mul_epu32(_mm256_set1_epi64x(nLimbs[0]), m));
+         ti[1] = _mm256_add_epi64(ti[1], _mm256_srli_epi64(ti[0], RADIX));
+         for (size_t j = 1; j < L; j++) {
+            __m256i p = _mm256_add_epi64(_mm256_mul_epu32(a[j], bi), _mm256_mul_epu32(_mm256_set1_epi64x(nLimbs[j]), m));
+            ti[j] = _mm256_add_epi64(ti[j], p);
+         }
+      }
+      __m256i carry = _mm256_setzero_si256();
+      for (size_t j = 0; j < L; j++) {
+         __m256i v = _mm256_add_epi64(t[L + j], carry);
+         out[j] = _mm256_and_si256(v, mask);
+         carry = _mm256_srli_epi64(v, RADIX);
+      }
+   }
+
+   BN_TARGET_AVX2 void powAvx2(const Num base[LANES], const Num &exp, Num out[LANES]) const {
+      size_t bits = exp.bitLength();
+      alignas(32) uint64_t lanes[L][LANES];
+      __m256i *x = reinterpret_cast<__m256i *>(lanes);
+      __m256i r2[L], acc[L];
+      for (size_t j = 0; j < L; j++)
+         r2[j] = _mm256_set1_epi64x(r2Limbs[j]);
+      // Window table of odd powers, as in Montgomery::pow (w capped at 5 to keep it on the stack)
+      const int w = bits > 256 ? 5 : bits > 64 ? 4 : bits > 16 ? 3 : 1;
+      __m256i table[1 << 4][L];
+      for (size_t i = 0; i < LANES; i++) {
+         uint64_t limbs[L];
+         split(base[i], limbs);
+         for (size_t j = 0; j < L; j++)
+            lanes[j][i] = limbs[j];
+      }
+      mul(x, r2, table[0]);
+      mul(table[0], table[0], acc);
+      for (int i = 1; i < (1 << (w - 1)); i++)
+         mul(table[i - 1], acc, table[i]);
+      // acc = R mod n (Montgomery 1) = 1 * R^2 / R
+      for (size_t j = 0; j < L; j++)
+         x[j] = _mm256_set1_epi64x(j == 0);
+      mul(x, r2, acc);
+      size_t i = bits;
+      while (i > 0) {
+         if (!exp.bit(i - 1)) {
+            mul(acc, acc, acc);
+            i--;
+            continue;
+         }
+         size_t len = std::min<size_t>(w, i);
+         while (!exp.bit(i - len))
+            len--;
+         unsigned value = 0;
+         for (size_t k = 0; k < len; k++)
+            value = (value << 1) | exp.bit(i - 1 - k);
+         for (size_t k = 0; k < len; k++)
+            mul(acc, acc, acc);
+         mul(acc, table[value >> 1], acc);
+         i -= len;
+      }
+      // Leave the Montgomery domain (multiply by 1), then the one conditional subtraction
+      for (size_t j = 0; j < L; j++)
+         x[j] = _mm256_set1_epi64x(j == 0);
+      mul(acc, x, x);
+      for (size_t l = 0; l < LANES; l++) {
+         UInt<Bits + 64> r = join(&lanes[0][l], LANES);
+         if (r >= UInt<Bits + 64>(n))
+            r.subFrom(UInt<Bits + 64>(n));
+         out[l] = Num(r);
+      }
+   }
+#endif
+};
+
+//  One-off base^exp mod n; build a Montgomery once instead when the modulus is reused
+template <size_t Bits> UInt<Bits> powMod(const UInt<Bits> &base, const UInt<Bits> &exp, const UInt<Bits> &mod) {
+   return Montgomery<Bits>(mod).pow(base, exp);
+}
+
+} // namespace bn
@@ -0,0 +1,176 @@
+/*----------------------------------------------------Key Exchange Demo & Self-Checks 🤝----------------------------------------------------*/
+/* Author      : Hassan (a.k.a. The Eagle 🦅)
+ * Description : Demo for KeyExchange.hpp — Alice and Bob agree on a secret with FFDH-2048 and with X25519.
+ *               ./KeyExchange --bench runs the known answers (RFC 7748 vectors, RFC 3526 groups against a
+ *               Python model) and reports handshakes per second, comb versus generic key generation.
+ *
+ * Build       : g++ -std=c++17 -O2 -pthread KeyExchange.cpp -o KeyExchange
+ *
+ * License     : Public Domain / MIT — use it, break it, improve it 👨‍💻
+ */
+
+#include "KeyExchange.hpp"
+#include "../Hashing Algorithms/SHA256.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+using std::cout;
+using std::endl;
+
+template <class Bytes> std::string toHex(const Bytes &b) {
+   static const char *digits = "0123456789abcdef";
+   std::string s;
+   for (uint8_t v : b) {
+      s += digits[v >> 4];
+      s += digits[v & 15];
+   }
+   return s;
+}
+
+static kex::X25519::Key keyFromHex(const std::string &hex) {
+   kex::X25519::Key k;
+   for (size_t i = 0; i < k.size(); i++)
+      k[i] = (uint8_t)std::stoul(hex.substr(2 * i, 2), nullptr, 16);
+   return k;
+}
+
+/*----------------------------------------------------Known Answers----------------------------------------------------*/
+// RFC 7748 5.2 (two scalar multiplications, the iterated test) and 6.1 (Alice and Bob)
+bool checkX25519() {
+   using kex::X25519;
+   bool ok = toHex(X25519::scalarMult(keyFromHex("a546e36bf0527c9d3b16154b82465edd62144c0ac1fc5a18506a2244ba449ac4"),
+                                      keyFromHex("e6db6867583030db3594c1a424b15f7c726624ec26b3353b10a903a6d0ab1c4c"))) ==
+             "c3da55379de9c6908e94ea4df28d084f32eccf03491c71f754b4075577a28552";
+   ok = ok && toHex(X25519::scalarMult(keyFromHex("4b66e9d4d1b4673c5ad22691957d6af5c11b6421e0ea01d42ca4169e7918ba0d"),
+                                       keyFromHex("e5210f12786811d3f4b7959d0538ae2c31dbe7106fc03c3efc4cd549c715a493"))) ==
+                  "95cbde9476e8907d7aade45cb4b873f88b595a68799fa152e6f8f7647aac7957";
+
+   X25519::Key k = X25519::basePoint(), u = k;
+   for (int i = 1; i <= 1000; i++) {
+      X25519::Key next = X25519::scalarMult(k, u);
+      u = k;
+      k = next;
+      if (i == 1)
+         ok = ok && toHex(k) == "422c8e7a6227d7bca1350b3e2bb7279f7897b87bb6854b783c60e80311ae3079";
+   }
+   ok = ok && toHex(k) == "684cf59ba83309552800ef566f2f4d3c1c3887c49360e3875f2eb94d99532c51";
+
+   const X25519::Key alice = keyFromHex("77076d0a7318a57d3c16c17251b26645df4c2f87ebc0992ab177fba51db92c2a");
+   const X25519::Key bob = keyFromHex("5dab087e624a8a4b79e17f8b83800ee66f3bb1292618b6fd1c2f8b27ff88e0eb");
+   const X25519::Key alicePub = X25519::publicKey(alice), bobPub = X25519::publicKey(bob);
+   ok = ok && toHex(alicePub) == "8520f0098930a754748b7ddcb43ef75a0dbf3a0d26381af4eba4a98eaa9b4e6a";
+   ok = ok && toHex(bobPub) == "de9edb7d7b7dc1b4d35b61c2ece435373f8343c85b78674dadfc7e146f882b4f";
+   const std::string shared = "4a5d9d5ba4ce2de1728e3bf480350f25e07e21c947d19e3376f09b3c1e161742";
+   ok = ok && toHex(X25519::sharedSecret(alice, bobPub)) == shared && toHex(X25519::sharedSecret(bob, alicePub)) == shared;
+
+   // The comb and the ladder must agree on random keys too
+   for (int i = 0; i < 64 && ok; i++) {
+      X25519::KeyPair kp = X25519::generateKeyPair();
+      ok = kp.publicKey == X25519::scalarMult(kp.privateKey, X25519::basePoint());
+   }
+   return ok;
+}
+
+// x = 0x0102...1c in each group: SHA-256 of g^x (big-endian, full width), from an independent Python model;
+// then the comb against the generic window on random exponents, and both sides of a handshake
+template <size_t Bits> bool checkFFDH(const char *digest) {
+   using DH = kex::FFDH<Bits>;
+   const DH &group = DH::modp();
+   uint8_t x[28], y[DH::BYTES];
+   for (int i = 0; i < 28; i++)
+      x[i] = (uint8_t)(i + 1);
+   group.keyPairFromPrivate(DH::Num::fromBytes(x, sizeof(x))).publicKey.toBytes(y, sizeof(y));
+   bool ok = toHex(SHA256::hash(y, sizeof(y))) == digest;
+
+   const bn::Montgomery<Bits> mont(group.prime());
+   for (int i = 0; i < 8 && ok; i++) {
+      typename DH::KeyPair kp = group.generateKeyPair();
+      ok = kp.publicKey == mont.pow(group.generator(), kp.privateKey);
+   }
+   typename DH::KeyPair a = group.generateKeyPair(), b = group.generateKeyPair();
+   return ok && group.sharedSecret(a.privateKey, b.publicKey) == group.sharedSecret(b.privateKey, a.publicKey);
+}
+
+/*----------------------------------------------------Handshakes / Second----------------------------------------------------*/
+// One side of an ephemeral handshake: a fresh key pair, then the shared secret with the peer's public value
+template <class Fn> double perSecond(Fn &&fn) {
+   fn();
+   size_t count = 0;
+   auto start = std::chrono::steady_clock::now();
+   std::chrono::duration<double> secs{};
+   while (secs.count() < 0.3) {
+      fn();
+      count++;
+      secs = std::chrono::steady_clock::now() - start;
+   }
+   return count / secs.count();
+}
+
+template <size_t Bits> void ffdhThroughput() {
+   using DH = kex::FFDH<Bits>;
+   const DH &group = DH::modp();
+   const bn::Montgomery<Bits> mont(group.prime());
+   const typename DH::KeyPair peer = group.generateKeyPair();
+   typename DH::Num x = group.generateKeyPair().privateKey, sink; // bit 0 of x flips per call so the loop can't be hoisted
+   double comb = perSecond([&] { sink = group.generateKeyPair().publicKey; });
+   double window = perSecond([&] { x.limb[0] ^= 1; sink = mont.powSecret(group.generator(), x, group.privateBits()); });
+   double handshakes = perSecond([&] { sink = group.sharedSecret(group.generateKeyPair().privateKey, peer.publicKey); });
+   cout << "  FFDH-" << std::left << std::setw(6) << Bits << std::right << std::fixed << std::setprecision(0) << " keygen comb "
+        << std::setw(8) << comb << "/s   window " << std::setw(8) << window << "/s   handshakes " << std::setw(8) << handshakes
+        << "/s" << endl;
+}
+
+void x25519Throughput() {
+   using kex::X25519;
+   const X25519::KeyPair peer = X25519::generateKeyPair();
+   X25519::Key key = peer.privateKey, sink;
+   double comb = perSecond([&] { sink = X25519::publicKey(key); key[0]++; });
+   double ladder = perSecond([&] { sink = X25519::scalarMult(key, X25519::basePoint()); key[0]++; });
+   double handshakes = perSecond([&] { sink = X25519::sharedSecret(X25519::generateKeyPair().privateKey, peer.publicKey); });
+   cout << "  X25519      " << std::fixed << std::setprecision(0) << " keygen comb " << std::setw(8) << comb << "/s   ladder "
+        << std::setw(8) << ladder << "/s   handshakes " << std::setw(8) << handshakes << "/s" << endl;
+}
+
+bool benchmark() {
+   const bool x = checkX25519();
+   const bool f = checkFFDH<2048>("334bb3d0393b494ca042e9aa05b30318519cbc20e8a1d751c385c86606b3e740") &&
+                  checkFFDH<3072>("90bd16760a1c1aada34e2f5715ffb9fc40f32a6dcd947eb65d79244fea5ef0c7") &&
+                  checkFFDH<4096>("67911e5309d53f9f024ed28a3e13cf77666c3483988e3305f1900e5b0e4f18de") &&
+                  checkFFDH<6144>("54cdbb3b6736680865250a082a24ee880bc07cdafc1f96b4432b6a4c116c48e0") &&
+                  checkFFDH<8192>("71c5f7f4e7a4fc48a913b4abc40eca82126be501cb4f19f5c7150fce211d7c95");
+   cout << "X25519 RFC 7748 known answers: " << (x ? "PASS" : "FAIL") << endl;
+   cout << "FFDH RFC 3526 groups 14-18 known answers: " << (f ? "PASS" : "FAIL") << endl;
+   x25519Throughput();
+   ffdhThroughput<2048>();
+   ffdhThroughput<3072>();
+   ffdhThroughput<4096>();
+   return x && f;
+}
+
+/*----------------------------------------------------Main----------------------------------------------------*/
+int main(int argc, char *argv[]) {
+   if (argc > 1 && std::string(argv[1]) == "--bench")
+      return benchmark() ? 0 : 1;
+
+   // Each side sends only its public value; both arrive at the same secret
+   using DH = kex::FFDH<2048>;
+   const DH &group = DH::modp();
+   DH::KeyPair alice = group.generateKeyPair(), bob = group.generateKeyPair();
+   uint8_t alicePub[DH::BYTES], bobPub[DH::BYTES], aliceSecret[DH::BYTES], bobSecret[DH::BYTES];
+   alice.publicKey.toBytes(alicePub, DH::BYTES);
+   bob.publicKey.toBytes(bobPub, DH::BYTES);
+   group.sharedSecret(alice.privateKey, bobPub, aliceSecret);
+   group.sharedSecret(bob.privateKey, alicePub, bobSecret);
+   cout << "FFDH-2048 shared secret: " << toHex(std::vector<uint8_t>(aliceSecret, aliceSecret + 16)) << "... "
+        << (std::equal(aliceSecret, aliceSecret + DH::BYTES, bobSecret) ? "(match)" : "(MISMATCH)") << endl;
+
+   kex::X25519::KeyPair a = kex::X25519::generateKeyPair(), b = kex::X25519::generateKeyPair();
+   kex::X25519::Key s1 = kex::X25519::sharedSecret(a.privateKey, b.publicKey), s2 = kex::X25519::sharedSecret(b.privateKey, a.publicKey);
+   cout << "X25519 shared secret:    " << toHex(s1) << " " << (s1 == s2 ? "(match)" : "(MISMATCH)") << endl;
+
+   std::string slogan = "<------------------------The Eagle------------------------>";
+   cout << endl << std::setw(80) << slogan << endl;
+}
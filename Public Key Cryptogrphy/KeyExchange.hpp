@@ -0,0 +1,559 @@
+/*----------------------------------------------------Key Exchange (FFDH + X25519) 🤝----------------------------------------------------*/
+/* Author      : Hassan (a.k.a. The Eagle 🦅)
+ * Description : Ephemeral Diffie-Hellman key agreement, two flavours:
+ *               - FFDH over the RFC 3526 MODP groups (2048 - 8192 bits, generator 2) on the Montgomery layer of
+ *                 BigNum.hpp; g^x comes from a fixed-base comb table built once per group (Lim-Lee, 8 teeth,
+ *                 2 tables), so a fresh key pair costs a third to a fifth of powSecret over the same exponent
+ *               - X25519 (RFC 7748): the Montgomery ladder for shared secrets, and for new key pairs a fixed-base
+ *                 comb on the birationally equivalent Edwards curve (32 x 8 precomputed multiples of the base
+ *                 point, signed radix-16 digits), mapped back to u = (1 + y) / (1 - y)
+ *               - Private keys from the thread-local AES CTR_DRBG in AES.hpp
+ *
+ * Note        : X25519 runs in constant time (ladder swaps and table reads are masks, not branches), and so do
+ *               FFDH's private-key operations: the comb reads its table by mask and shared secrets go through
+ *               Montgomery::powSecret. Only the public values are checked with variable-time code.
+ *
+ * Usage       : #include "KeyExchange.hpp" — KeyExchange.cpp is the demo (./KeyExchange --bench for the checks)
+ *
+ * License     : Public Domain / MIT — use it, break it, improve it 👨‍💻
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "../Symmetric Key Cryptography/AES.hpp"
+#include "BigNum.hpp"
+
+namespace kex {
+
+/*----------------------------------------------------RFC 3526 Groups----------------------------------------------------*/
+//  p = 2^N - 2^(N-64) - 1 + 2^64 * ([2^(N-130) pi] + k), a safe prime; the generator is 2 for every group
+template <size_t Bits> const char *modpPrimeHex();
+
+template <> inline const char *modpPrimeHex<2048>() {
+   return "FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD129024E088A67CC74020BBEA63B139B22514A08798E3404DD"
+          "EF9519B3CD3A431B302B0A6DF25F14374FE1356D6D51C245E485B576625E7EC6F44C42E9A637ED6B0BFF5CB6F406B7ED"
+          "EE386BFB5A899FA5AE9F24117C4B1FE649286651ECE45B3DC2007CB8A163BF0598DA48361C55D39A69163FA8FD24CF5F"
+          "83655D23DCA3AD961C62F356208552BB9ED529077096966D670C354E4ABC9804F1746C08CA18217C32905E462E36CE3B"
+          "E39E772C180E86039B2783A2EC07A28FB5C55DF06F4C52C9DE2BCBF6955817183995497CEA956AE515D2261898FA0510"
+          "15728E5A8AACAA68FFFFFFFFFFFFFFFF";
+}
+template <> inline const char *modpPrimeHex<3072>() {
+   return "FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD129024E088A67CC74020BBEA63B139B22514A08798E3404DD"
+          "EF9519B3CD3A431B302B0A6DF25F14374FE1356D6D51C245E485B576625E7EC6F44C42E9A637ED6B0BFF5CB6F406B7ED"
+          "EE386BFB5A899FA5AE9F24117C4B1FE649286651ECE45B3DC2007CB8A163BF0598DA48361C55D39A69163FA8FD24CF5F"
+          "83655D23DCA3AD961C62F356208552BB9ED529077096966D670C354E4ABC9804F1746C08CA18217C32905E462E36CE3B"
+          "E39E772C180E86039B2783A2EC07A28FB5C55DF06F4C52C9DE2BCBF6955817183995497CEA956AE515D2261898FA0510"
+          "15728E5A8AAAC42DAD33170D04507A33A85521ABDF1CBA64ECFB850458DBEF0A8AEA71575D060C7DB3970F85A6E1E4C7"
+          "ABF5AE8CDB0933D71E8C94E04A25619DCEE3D2261AD2EE6BF12FFA06D98A0864D87602733EC86A64521F2B18177B200C"
+          "BBE117577A615D6C770988C0BAD946E208E24FA074E5AB3143DB5BFCE0FD108E4B82D120A93AD2CAFFFFFFFFFFFFFFFF";
+}
+template <> inline const char *modpPrimeHex<4096>() {
+   return "FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD129024E088A67CC74020BBEA63B139B22514A08798E3404DD"
+          "EF9519B3CD3A431B302B0A6DF25F14374FE1356D6D51C245E485B576625E7EC6F44C42E9A637ED6B0BFF5CB6F406B7ED"
+          "EE386BFB5A899FA5AE9F24117C4B1FE649286651ECE45B3DC2007CB8A163BF0598DA48361C55D39A69163FA8FD24CF5F"
+          "83655D23DCA3AD961C62F356208552BB9ED529077096966D670C354E4ABC9804F1746C08CA18217C32905E462E36CE3B"
+          "E39E772C180E86039B2783A2EC07A28FB5C55DF06F4C52C9DE2BCBF6955817183995497CEA956AE515D2261898FA0510"
+          "15728E5A8AAAC42DAD33170D04507A33A85521ABDF1CBA64ECFB850458DBEF0A8AEA71575D060C7DB3970F85A6E1E4C7"
+          "ABF5AE8CDB0933D71E8C94E04A25619DCEE3D2261AD2EE6BF12FFA06D98A0864D87602733EC86A64521F2B18177B200C"
+          "BBE117577A615D6C770988C0BAD946E208E24FA074E5AB3143DB5BFCE0FD108E4B82D120A92108011A723C12A787E6D7"
+          "88719A10BDBA5B2699C327186AF4E23C1A946834B6150BDA2583E9CA2AD44CE8DBBBC2DB04DE8EF92E8EFC141FBECAA6"
+          "287C59474E6BC05D99B2964FA090C3A2233BA186515BE7ED1F612970CEE2D7AFB81BDD762170481CD0069127D5B05AA9"
+          "93B4EA988D8FDDC186FFB7DC90A6C08F4DF435C934063199FFFFFFFFFFFFFFFF";
+}
+template <> inline const char *modpPrimeHex<6144>() {
+   return "FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD129024E088A67CC74020BBEA63B139B22514A08798E3404DD"
+          "EF9519B3CD3A431B302B0A6DF25F14374FE1356D6D51C245E485B576625E7EC6F44C42E9A637ED6B0BFF5CB6F406B7ED"
+          "EE386BFB5A899FA5AE9F24117C4B1FE649286651ECE45B3DC2007CB8A163BF0598DA48361C55D39A69163FA8FD24CF5F"
+          "83655D23DCA3AD961C62F356208552BB9ED529077096966D670C354E4ABC9804F1746C08CA18217C32905E462E36CE3B"
+          "E39E772C180E86039B2783A2EC07A28FB5C55DF06F4C52C9DE2BCBF6955817183995497CEA956AE515D2261898FA0510"
+          "15728E5A8AAAC42DAD33170D04507A33A85521ABDF1CBA64ECFB850458DBEF0A8AEA71575D060C7DB3970F85A6E1E4C7"
+          "ABF5AE8CDB0933D71E8C94E04A25619DCEE3D2261AD2EE6BF12FFA06D98A0864D87602733EC86A64521F2B18177B200C"
+          "BBE117577A615D6C770988C0BAD946E208E24FA074E5AB3143DB5BFCE0FD108E4B82D120A92108011A723C12A787E6D7"
+          "88719A10BDBA5B2699C327186AF4E23C1A946834B6150BDA2583E9CA2AD44CE8DBBBC2DB04DE8EF92E8EFC141FBECAA6"
+          "287C59474E6BC05D99B2964FA090C3A2233BA186515BE7ED1F612970CEE2D7AFB81BDD762170481CD0069127D5B05AA9"
+          "93B4EA988D8FDDC186FFB7DC90A6C08F4DF435C93402849236C3FAB4D27C7026C1D4DCB2602646DEC9751E763DBA37BD"
+          "F8FF9406AD9E530EE5DB382F413001AEB06A53ED9027D831179727B0865A8918DA3EDBEBCF9B14ED44CE6CBACED4BB1B"
+          "DB7F1447E6CC254B332051512BD7AF426FB8F401378CD2BF5983CA01C64B92ECF032EA15D1721D03F482D7CE6E74FEF6"
+          "D55E702F46980C82B5A84031900B1C9E59E7C97FBEC7E8F323A97A7E36CC88BE0F1D45B7FF585AC54BD407B22B4154AA"
+          "CC8F6D7EBF48E1D814CC5ED20F8037E0A79715EEF29BE32806A1D58BB7C5DA76F550AA3D8A1FBFF0EB19CCB1A313D55C"
+          "DA56C9EC2EF29632387FE8D76E3C0468043E8F663F4860EE12BF2D5B0B7474D6E694F91E6DCC4024FFFFFFFFFFFFFFFF";
+}
+template <> inline const char *modpPrimeHex<8192>() {
+   return "FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD129024E088A67CC74020BBEA63B139B22514A08798E3404DD"
+          "EF9519B3CD3A431B302B0A6DF25F14374FE1356D6D51C245E485B576625E7EC6F44C42E9A637ED6B0BFF5CB6F406B7ED"
+          "EE386BFB5A899FA5AE9F24117C4B1FE649286651ECE45B3DC2007CB8A163BF0598DA48361C55D39A69163FA8FD24CF5F"
+          "83655D23DCA3AD961C62F356208552BB9ED529077096966D670C354E4ABC9804F1746C08CA18217C32905E462E36CE3B"
+          "E39E772C180E86039B2783A2EC07A28FB5C55DF06F4C52C9DE2BCBF6955817183995497CEA956AE515D2261898FA0510"
+          "15728E5A8AAAC42DAD33170D04507A33A85521ABDF1CBA64ECFB850458DBEF0A8AEA71575D060C7DB3970F85A6E1E4C7"
+          "ABF5AE8CDB0933D71E8C94E04A25619DCEE3D2261AD2EE6BF12FFA06D98A0864D87602733EC86A64521F2B18177B200C"
+          "BBE117577A615D6C770988C0BAD946E208E24FA074E5AB3143DB5BFCE0FD108E4B82D120A92108011A723C12A787E6D7"
+          "88719A10BDBA5B2699C327186AF4E23C1A946834B6150BDA2583E9CA2AD44CE8DBBBC2DB04DE8EF92E8EFC141FBECAA6"
+          "287C59474E6BC05D99B2964FA090C3A2233BA186515BE7ED1F612970CEE2D7AFB81BDD762170481CD0069127D5B05AA9"
+          "93B4EA988D8FDDC186FFB7DC90A6C08F4DF435C93402849236C3FAB4D27C7026C1D4DCB2602646DEC9751E763DBA37BD"
+          "F8FF9406AD9E530EE5DB382F413001AEB06A53ED9027D831179727B0865A8918DA3EDBEBCF9B14ED44CE6CBACED4BB1B"
+          "DB7F1447E6CC254B332051512BD7AF426FB8F401378CD2BF5983CA01C64B92ECF032EA15D1721D03F482D7CE6E74FEF6"
+          "D55E702F46980C82B5A84031900B1C9E59E7C97FBEC7E8F323A97A7E36CC88BE0F1D45B7FF585AC54BD407B22B4154AA"
+          "CC8F6D7EBF48E1D814CC5ED20F8037E0A79715EEF29BE32806A1D58BB7C5DA76F550AA3D8A1FBFF0EB19CCB1A313D55C"
+          "DA56C9EC2EF29632387FE8D76E3C0468043E8F663F4860EE12BF2D5B0B7474D6E694F91E6DBE115974A3926F12FEE5E4"
+          "38777CB6A932DF8CD8BEC4D073B931BA3BC832B68D9DD300741FA7BF8AFC47ED2576F6936BA424663AAB639C5AE4F568"
+          "3423B4742BF1C978238F16CBE39D652DE3FDB8BEFC848AD922222E04A4037C0713EB57A81A23F0C73473FC646CEA306B"
+          "4BCBC8862F8385DDFA9D4B7FA2C087E879683303ED5BDD3A062B3CF5B3A278A66D2A13F83F44F82DDF310EE074AB6A36"
+          "4597E899A0255DC164F31CC50846851DF9AB48195DED7EA1B1D510BD7EE74D73FAF36BC31ECFA268359046F4EB879F92"
+          "4009438B481C6CD7889A002ED5EE382BC9190DA6FC026E479558E4475677E9AA9E3050E2765694DFC81F56E880B96E71"
+          "60C980DD98EDD3DFFFFFFFFFFFFFFFFF";
+}
+
+//  Private exponent length: twice the group's security strength (SP 800-56A / RFC 7919, what OpenSSL draws)
+template <size_t Bits> constexpr size_t modpPrivateBits() {
+   static_assert(Bits == 2048 || Bits == 3072 || Bits == 4096 || Bits == 6144 || Bits == 8192, "No RFC 3526 group of this size");
+   return Bits == 2048 ? 225 : Bits == 3072 ? 275 : Bits == 4096 ? 325 : Bits == 6144 ? 375 : 400;
+}
+
+/*----------------------------------------------------Finite-Field Diffie-Hellman----------------------------------------------------*/
+//  One group (p, g) with its Montgomery context and the comb table for g; immutable after construction, so a
+//  single instance serves every thread. FFDH<2048>::modp() is RFC 3526 group 14, 3072 / 4096 / 6144 / 8192
+//  are groups 15 - 18. Public values and shared secrets travel as BYTES big-endian bytes (leading zeros kept).
+template <size_t Bits> class FFDH {
+ public:
+   using Num = bn::UInt<Bits>;
+   static constexpr size_t BYTES = Bits / 8;
+   static constexpr size_t COMB_TEETH = 8;  // exponent bits gathered into one table index
+   static constexpr size_t COMB_TABLES = 2; // tables per comb (halves the squarings, doubles the memory)
+
+   struct KeyPair {
+      Num privateKey, publicKey;
+   };
+
+   //  The RFC 3526 group of this size, built on first use
+   static const FFDH &modp() {
+      static const FFDH group(Num::fromHex(modpPrimeHex<Bits>()), Num(2), modpPrivateBits<Bits>());
+      return group;
+   }
+
+   //  Any safe-prime group: p odd, 1 < g < p - 1, private exponents of privateBits bits (< bits of p)
+   FFDH(const Num &p, const Num &g, size_t privateBits) : mont(p), g(g), xBits(privateBits) {
+      if (g <= Num(1) || g >= p - Num(1))
+         throw std::invalid_argument("DH generator must be between 2 and p - 2!");
+      if (privateBits < 2 || privateBits >= p.bitLength() || privateBits + COMB_TEETH > Bits)
+         throw std::invalid_argument("DH private exponent must be shorter than the prime!");
+      one = mont.toMont(Num(1));
+      rows = (xBits + COMB_TEETH - 1) / COMB_TEETH;
+      cols = (rows + COMB_TABLES - 1) / COMB_TABLES;
+      buildComb();
+   }
+
+   const Num &prime() const { return mont.modulus(); }
+   const Num &generator() const { return g; }
+   size_t privateBits() const { return xBits; }
+
+   //  g^x mod p; the comb covers exponents up to privateBits() bits, longer ones take powSecret. Every column
+   //  multiplies by a masked read of the whole table (comb[j][0] = 1 for an all-zero column), so neither the
+   //  operation count nor the memory touched depends on x.
+   Num powG(const Num &x) const {
+      if (x.bitLength() > xBits)
+         return mont.powSecret(g, x);
+      // Bit k * rows + j * cols + s of x is tooth k of column s in table j
+      Num acc = one;
+      for (size_t s = cols; s-- > 0;) {
+         acc = mont.mul(acc, acc);
+         for (size_t j = 0; j < COMB_TABLES && j * cols + s < rows; j++) {
+            unsigned idx = 0;
+            for (size_t k = 0; k < COMB_TEETH; k++)
+               idx |= (unsigned)x.bit(k * rows + j * cols + s) << k;
+            acc = mont.mul(acc, bn::Montgomery<Bits>::select(&comb[j << COMB_TEETH], 1u << COMB_TEETH, idx));
+         }
+      }
+      return mont.fromMont(acc);
+   }
+
+   //  Fresh ephemeral key pair: x uniform in [1, 2^privateBits), y = g^x
+   KeyPair generateKeyPair() const {
+      uint8_t buf[BYTES];
+      const size_t bytes = (xBits + 7) / 8;
+      Num x;
+      while (x.isZero()) {
+         aes::randomBytes(buf, bytes);
+         x = Num::fromBytes(buf, bytes);
+         x = (x << (Bits - xBits)) >> (Bits - xBits);
+      }
+      return {x, powG(x)};
+   }
+   KeyPair keyPairFromPrivate(const Num &x) const {
+      if (x.isZero() || x >= prime() - Num(1))
+         throw std::invalid_argument("DH private key must be between 1 and p - 2!");
+      return {x, powG(x)};
+   }
+
+   //  Range check of SP 800-56A 5.6.2.3.2: rules out 0, 1 and p - 1 (the elements of order 1 and 2)
+   bool isValidPublic(const Num &y) const { return y > Num(1) && y < prime() - Num(1); }
+
+   //  z = peer^x mod p; throws on an invalid peer value
+   Num sharedSecret(const Num &x, const Num &peer) const {
+      if (!isValidPublic(peer))
+         throw std::invalid_argument("Invalid DH public value!");
+      Num z = mont.powSecret(peer, x, x.bitLength() > xBits ? Bits : xBits);
+      if (z == Num(1))
+         throw std::invalid_argument("Invalid DH public value!");
+      return z;
+   }
+   void sharedSecret(const Num &x, const uint8_t peer[BYTES], uint8_t out[BYTES]) const {
+      sharedSecret(x, Num::fromBytes(peer, BYTES)).toBytes(out, BYTES);
+   }
+
+ private:
+   bn::Montgomery<Bits> mont;
+   Num g, one;
+   size_t xBits, rows, cols;
+   std::vector<Num> comb; // COMB_TABLES x 2^COMB_TEETH Montgomery residues
+
+   //  comb[j][i] = product over the set bits k of i of g^(2^(k * rows + j * cols))
+   void buildComb() {
+      comb.assign(COMB_TABLES << COMB_TEETH, one);
+      Num power = mont.toMont(g); // g^(2^bit)
+      for (size_t bit = 0; bit < COMB_TEETH * rows; bit++) {
+         const size_t k = bit / rows, j = bit % rows / cols;
+         if (bit % rows % cols == 0 && j < COMB_TABLES)
+            comb[j << COMB_TEETH | 1u << k] = power;
+         power = mont.mul(power, power);
+      }
+      for (size_t j = 0; j < COMB_TABLES; j++)
+         for (unsigned i = 3; i < 1u << COMB_TEETH; i++)
+            if (i & (i - 1))
+               comb[j << COMB_TEETH | i] = mont.mul(comb[j << COMB_TEETH | (i & (i - 1))], comb[j << COMB_TEETH | (i & (0 - i))]);
+   }
+};
+
+/*----------------------------------------------------Field Arithmetic mod 2^255 - 19----------------------------------------------------*/
+//  Five 51-bit limbs, least significant first. Every operation leaves each limb below 2^52, which keeps the
+//  25 partial products of a multiplication (with the 19 folding) inside 128 bits.
+struct Fe {
+   uint64_t v[5];
+};
+
+constexpr uint64_t FE_MASK = (1ULL << 51) - 1;
+
+inline Fe feSmall(uint64_t x) { return {{x, 0, 0, 0, 0}}; }
+
+inline void feCarry(Fe &r) {
+   for (int pass = 0; pass < 2; pass++) {
+      for (int i = 0; i < 4; i++) {
+         r.v[i + 1] += r.v[i] >> 51;
+         r.v[i] &= FE_MASK;
+      }
+      r.v[0] += 19 * (r.v[4] >> 51);
+      r.v[4] &= FE_MASK;
+   }
+}
+
+inline Fe feAdd(const Fe &a, const Fe &b) {
+   Fe r;
+   for (int i = 0; i < 5; i++)
+      r.v[i] = a.v[i] + b.v[i];
+   feCarry(r);
+   return r;
+}
+
+//  a - b + 4p, so no limb goes negative
+inline Fe feSub(const Fe &a, const Fe &b) {
+   Fe r;
+   r.v[0] = a.v[0] + 0x1FFFFFFFFFFFB4 - b.v[0];
+   for (int i = 1; i < 5; i++)
+      r.v[i] = a.v[i] + 0x1FFFFFFFFFFFFC - b.v[i];
+   feCarry(r);
+   return r;
+}
+
+inline Fe feFromWide(bn::u128 t0, bn::u128 t1, bn::u128 t2, bn::u128 t3, bn::u128 t4) {
+   Fe r;
+   t1 += (uint64_t)(t0 >> 51);
+   t2 += (uint64_t)(t1 >> 51);
+   t3 += (uint64_t)(t2 >> 51);
+   t4 += (uint64_t)(t3 >> 51);
+   r.v[0] = ((uint64_t)t0 & FE_MASK) + 19 * (uint64_t)(t4 >> 51);
+   r.v[1] = ((uint64_t)t1 & FE_MASK) + (r.v[0] >> 51);
+   r.v[0] &= FE_MASK;
+   r.v[2] = (uint64_t)t2 & FE_MASK;
+   r.v[3] = (uint64_t)t3 & FE_MASK;
+   r.v[4] = (uint64_t)t4 & FE_MASK;
+   return r;
+}
+
+inline Fe feMul(const Fe &a, const Fe &b) {
+   using bn::u128;
+   const uint64_t b1 = 19 * b.v[1], b2 = 19 * b.v[2], b3 = 19 * b.v[3], b4 = 19 * b.v[4];
+   const uint64_t *x = a.v, *y = b.v;
+   return feFromWide((u128)x[0] * y[0] + (u128)x[1] * b4 + (u128)x[2] * b3 + (u128)x[3] * b2 + (u128)x[4] * b1,
+                     (u128)x[0] * y[1] + (u128)x[1] * y[0] + (u128)x[2] * b4 + (u128)x[3] * b3 + (u128)x[4] * b2,
+                     (u128)x[0] * y[2] + (u128)x[1] * y[1] + (u128)x[2] * y[0] + (u128)x[3] * b4 + (u128)x[4] * b3,
+                     (u128)x[0] * y[3] + (u128)x[1] * y[2] + (u128)x[2] * y[1] + (u128)x[3] * y[0] + (u128)x[4] * b4,
+                     (u128)x[0] * y[4] + (u128)x[1] * y[3] + (u128)x[2] * y[2] + (u128)x[3] * y[1] + (u128)x[4] * y[0]);
+}
+
+inline Fe feSq(const Fe &a) {
+   using bn::u128;
+   const uint64_t *x = a.v;
+   const uint64_t d0 = 2 * x[0], d1 = 2 * x[1], d2 = 2 * x[2], d3 = 2 * x[3], x3 = 19 * x[3], x4 = 19 * x[4];
+   return feFromWide((u128)x[0] * x[0] + (u128)d1 * x4 + (u128)d2 * x3, (u128)d0 * x[1] + (u128)d2 * x4 + (u128)x[3] * x3,
+                     (u128)d0 * x[2] + (u128)x[1] * x[1] + (u128)d3 * x4, (u128)d0 * x[3] + (u128)d1 * x[2] + (u128)x[4] * x4,
+                     (u128)d0 * x[4] + (u128)d1 * x[3] + (u128)x[2] * x[2]);
+}
+
+inline Fe feSqN(Fe a, int n) {
+   while (n--)
+      a = feSq(a);
+   return a;
+}
+
+inline Fe feMulSmall(const Fe &a, uint64_t c) {
+   using bn::u128;
+   return feFromWide((u128)a.v[0] * c, (u128)a.v[1] * c, (u128)a.v[2] * c, (u128)a.v[3] * c, (u128)a.v[4] * c);
+}
+
+//  z^(p - 2) = z^-1 (0 for z = 0)
+inline Fe feInvert(const Fe &z) {
+   Fe z2 = feSq(z);
+   Fe z9 = feMul(feSqN(z2, 2), z);
+   Fe z11 = feMul(z9, z2);
+   Fe x5 = feMul(feSq(z11), z9); // z^(2^5 - 1)
+   Fe x10 = feMul(feSqN(x5, 5), x5);
+   Fe x20 = feMul(feSqN(x10, 10), x10);
+   Fe x40 = feMul(feSqN(x20, 20), x20);
+   Fe x50 = feMul(feSqN(x40, 10), x10);
+   Fe x100 = feMul(feSqN(x50, 50), x50);
+   Fe x200 = feMul(feSqN(x100, 100), x100);
+   Fe x250 = feMul(feSqN(x200, 50), x50);
+   return feMul(feSqN(x250, 5), z11); // 2^255 - 32 + 11 = p - 2
+}
+
+//  Swaps a and b when swap is 1, without a branch
+inline void feSwap(Fe &a, Fe &b, uint64_t swap) {
+   const uint64_t mask = 0 - swap;
+   for (int i = 0; i < 5; i++) {
+      uint64_t t = mask & (a.v[i] ^ b.v[i]);
+      a.v[i] ^= t;
+      b.v[i] ^= t;
+   }
+}
+
+inline uint64_t load64LE(const uint8_t *p) {
+   uint64_t r = 0;
+   for (int i = 7; i >= 0; i--)
+      r = r << 8 | p[i];
+   return r;
+}
+
+//  32 little-endian bytes; bit 255 is ignored (RFC 7748 5)
+inline Fe feFromBytes(const uint8_t in[32]) {
+   return {{load64LE(in) & FE_MASK, load64LE(in + 6) >> 3 & FE_MASK, load64LE(in + 12) >> 6 & FE_MASK,
+            load64LE(in + 19) >> 1 & FE_MASK, load64LE(in + 24) >> 12 & FE_MASK}};
+}
+
+//  Fully reduced (0 <= r < p) little-endian encoding
+inline void feToBytes(Fe r, uint8_t out[32]) {
+   feCarry(r);
+   // q = 1 exactly when r >= p: add 19 and see whether it carries out of bit 255
+   uint64_t q = (r.v[0] + 19) >> 51;
+   for (int i = 1; i < 5; i++)
+      q = (r.v[i] + q) >> 51;
+   r.v[0] += 19 * q;
+   for (int i = 0; i < 4; i++) {
+      r.v[i + 1] += r.v[i] >> 51;
+      r.v[i] &= FE_MASK;
+   }
+   r.v[4] &= FE_MASK;
+   const uint64_t w[4] = {r.v[0] | r.v[1] << 51, r.v[1] >> 13 | r.v[2] << 38, r.v[2] >> 26 | r.v[3] << 25, r.v[3] >> 39 | r.v[4] << 12};
+   for (int i = 0; i < 32; i++)
+      out[i] = (uint8_t)(w[i / 8] >> (8 * (i % 8)));
+}
+
+/*----------------------------------------------------X25519----------------------------------------------------*/
+//  RFC 7748 Diffie-Hellman on Curve25519. Keys are 32 raw bytes; a private key is clamped on use, so any 32
+//  random bytes will do. publicKey() takes the Edwards comb, sharedSecret() the ladder; both agree bit for bit.
+class X25519 {
+ public:
+   static constexpr size_t KEY_BYTES = 32;
+   using Key = std::array<uint8_t, KEY_BYTES>;
+
+   struct KeyPair {
+      Key privateKey, publicKey;
+   };
+
+   static Key basePoint() {
+      Key u{};
+      u[0] = 9;
+      return u;
+   }
+
+   //  k * u on the Montgomery curve (the X25519 function itself), constant-time ladder
+   static Key scalarMult(const Key &scalar, const Key &u) {
+      const Key k = clamp(scalar);
+      const Fe x1 = feFromBytes(u.data());
+      Fe x2 = feSmall(1), z2 = feSmall(0), x3 = x1, z3 = feSmall(1);
+      uint64_t swap = 0;
+      for (int t = 254; t >= 0; t--) {
+         const uint64_t bit = (k[t / 8] >> (t % 8)) & 1;
+         swap ^= bit;
+         feSwap(x2, x3, swap);
+         feSwap(z2, z3, swap);
+         swap = bit;
+         const Fe a = feAdd(x2, z2), aa = feSq(a), b = feSub(x2, z2), bb = feSq(b), e = feSub(aa, bb);
+         const Fe c = feAdd(x3, z3), d = feSub(x3, z3), da = feMul(d, a), cb = feMul(c, b);
+         x3 = feSq(feAdd(da, cb));
+         z3 = feMul(x1, feSq(feSub(da, cb)));
+         x2 = feMul(aa, bb);
+         z2 = feMul(e, feAdd(aa, feMulSmall(e, 121665)));
+      }
+      feSwap(x2, x3, swap);
+      feSwap(z2, z3, swap);
+      Key out;
+      feToBytes(feMul(x2, feInvert(z2)), out.data());
+      return out;
+   }
+
+   //  k * 9 through the fixed-base Edwards comb; same result as scalarMult(k, basePoint())
+   static Key publicKey(const Key &privateKey);
+
+   static KeyPair generateKeyPair() {
+      KeyPair kp;
+      aes::randomBytes(kp.privateKey.data(), KEY_BYTES);
+      kp.publicKey = publicKey(kp.privateKey);
+      return kp;
+   }
+
+   //  Shared secret with a peer's public key; throws on the all-zero result a small-order point gives (RFC 7748 6.1)
+   static Key sharedSecret(const Key &privateKey, const Key &peerPublic) {
+      Key z = scalarMult(privateKey, peerPublic);
+      uint8_t any = 0;
+      for (uint8_t b : z)
+         any |= b;
+      if (!any)
+         throw std::invalid_argument("Invalid X25519 public key!");
+      return z;
+   }
+
+ private:
+   static Key clamp(Key k) {
+      k[0] &= 248;
+      k[31] &= 127;
+      k[31] |= 64;
+      return k;
+   }
+
+   /*----------------------------------------------------Edwards Fixed-Base Comb----------------------------------------------------*/
+   //  -x^2 + y^2 = 1 + d x^2 y^2 is birationally equivalent to Curve25519 (u = (1 + y) / (1 - y)), and its
+   //  complete addition formulas make a precomputed table practical: table[i][j] = (j + 1) * 256^i * B.
+   struct Point { // extended coordinates: x = X / Z, y = Y / Z, T = XY / Z
+      Fe X, Y, Z, T;
+   };
+   struct Cached { // a table entry, ready to add
+      Fe YplusX, YminusX, Z, T2d;
+   };
+   struct Comb {
+      Fe d2;
+      Cached table[32][8];
+   };
+
+   static Point identity() { return {feSmall(0), feSmall(1), feSmall(1), feSmall(0)}; }
+
+   //  a + b (add-2008-hwcd-3, a = -1)
+   static Point add(const Point &p, const Cached &q) {
+      const Fe a = feMul(feSub(p.Y, p.X), q.YminusX), b = feMul(feAdd(p.Y, p.X), q.YplusX);
+      const Fe c = feMul(p.T, q.T2d), zz = feMul(p.Z, q.Z), d = feAdd(zz, zz);
+      const Fe e = feSub(b, a), f = feSub(d, c), g = feAdd(d, c), h = feAdd(b, a);
+      return {feMul(e, f), feMul(g, h), feMul(f, g), feMul(e, h)};
+   }
+
+   //  2p (dbl-2008-hwcd with E, F, G, H negated, which leaves the products unchanged)
+   static Point dbl(const Point &p) {
+      const Fe a = feSq(p.X), b = feSq(p.Y), zz = feSq(p.Z), c = feAdd(zz, zz);
+      const Fe h = feAdd(a, b), e = feSub(h, feSq(feAdd(p.X, p.Y))), g = feSub(a, b), f = feAdd(c, g);
+      return {feMul(e, f), feMul(g, h), feMul(f, g), feMul(e, h)};
+   }
+
+   static Cached toCached(const Point &p, const Fe &d2) { return {feAdd(p.Y, p.X), feSub(p.Y, p.X), p.Z, feMul(p.T, d2)}; }
+
+   static const Comb &comb() {
+      static const Comb c = [] {
+         Comb out;
+         // d = -121665 / 121666; B = (x, 4/5) with x even
+         const Fe d = feMul(feSub(feSmall(0), feSmall(121665)), feInvert(feSmall(121666)));
+         out.d2 = feAdd(d, d);
+         static const uint8_t bx[32] = {0x1a, 0xd5, 0x25, 0x8f, 0x60, 0x2d, 0x56, 0xc9, 0xb2, 0xa7, 0x25,
+                                        0x95, 0x60, 0xc7, 0x2c, 0x69, 0x5c, 0xdc, 0xd6, 0xfd, 0x31, 0xe2,
+                                        0xa4, 0xc0, 0xfe, 0x53, 0x6e, 0xcd, 0xd3, 0x36, 0x69, 0x21};
+         const Fe x = feFromBytes(bx), y = feMul(feSmall(4), feInvert(feSmall(5)));
+         Point base = {x, y, feSmall(1), feMul(x, y)};
+         for (int i = 0; i < 32; i++) {
+            const Cached b = toCached(base, out.d2);
+            Point multiple = base;
+            out.table[i][0] = b;
+            for (int j = 1; j < 8; j++) {
+               multiple = add(multiple, b);
+               out.table[i][j] = toCached(multiple, out.d2);
+            }
+            for (int k = 0; k < 8; k++) // base *= 256
+               base = dbl(base);
+         }
+         return out;
+      }();
+      return c;
+   }
+
+   static void cmov(Cached &r, const Cached &a, uint64_t move) {
+      const uint64_t mask = 0 - move;
+      Fe *dst[4] = {&r.YplusX, &r.YminusX, &r.Z, &r.T2d};
+      const Fe *src[4] = {&a.YplusX, &a.YminusX, &a.Z, &a.T2d};
+      for (int f = 0; f < 4; f++)
+         for (int i = 0; i < 5; i++)
+            dst[f]->v[i] ^= mask & (dst[f]->v[i] ^ src[f]->v[i]);
+   }
+
+   //  digit * 256^pos * B for a digit in [-8, 8], reading all eight entries so the index never shows in the cache
+   static Cached select(const Comb &c, int pos, int8_t digit) {
+      const uint64_t negative = (uint8_t)digit >> 7;
+      const uint64_t magnitude = (uint64_t)(digit - ((0 - (int)negative) & digit) * 2);
+      Cached r = {feSmall(1), feSmall(1), feSmall(1), feSmall(0)};
+      for (uint64_t j = 0; j < 8; j++)
+         cmov(r, c.table[pos][j], ((magnitude ^ (j + 1)) - 1) >> 63);
+      const Cached minus = {r.YminusX, r.YplusX, r.Z, feSub(feSmall(0), r.T2d)};
+      cmov(r, minus, negative);
+      return r;
+   }
+};
+
+inline X25519::Key X25519::publicKey(const Key &privateKey) {
+   const Key k = clamp(privateKey);
+   const Comb &c = comb();
+   // Signed radix-16 digits in [-8, 8): k = sum e[i] * 16^i
+   int8_t e[64];
+   for (int i = 0; i < 32; i++) {
+      e[2 * i] = k[i] & 15;
+      e[2 * i + 1] = k[i] >> 4;
+   }
+   int8_t carry = 0;
+   for (int i = 0; i < 63; i++) {
+      e[i] += carry;
+      carry = (int8_t)((e[i] + 8) >> 4);
+      e[i] -= (int8_t)(carry * 16);
+   }
+   e[63] += carry;
+   // Odd digits, times 16, then even digits: 64 table additions and 4 doublings in all
+   Point h = identity();
+   for (int i = 1; i < 64; i += 2)
+      h = add(h, select(c, i / 2, e[i]));
+   for (int i = 0; i < 4; i++)
+      h = dbl(h);
+   for (int i = 0; i < 64; i += 2)
+      h = add(h, select(c, i / 2, e[i]));
+   Key out;
+   feToBytes(feMul(feAdd(h.Z, h.Y), feInvert(feSub(h.Z, h.Y))), out.data());
+   return out;
+}
+
+} // namespace kex
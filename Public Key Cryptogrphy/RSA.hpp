@@ -0,0 +1,784 @@
+/*----------------------------------------------------RSA + Random Number Generator 🛡️----------------------------------------------------*/
+/* Author      : Hassan (a.k.a. The Eagle 🦅)
+ * Description : Core RSA encryption/decryption system using:
+ *               - Random prime number generation (sieve + Miller-Rabin for big primes, parallel search),
+ *                 drawing from the thread-local AES CTR_DRBG in AES.hpp
+ *               - Public/private key pair generation (e = 65537 by default, d by binary modular inverse)
+ *               - Modular exponentiation over fixed-width big integers (Montgomery, sliding window)
+ *               - CRT private-key operations (decrypt / sign) with a public-exponent fault check
+ *               - RSAES-OAEP (SHA-256) and PKCS#1 v1.5 padding, one modulus-sized block per operation
+ *               - Batch encrypt / verify for one key over the worker pool, four messages per AVX2 pass
+ *               - RSASSA-PSS (SHA-256) signatures, batch PSS verification, and an LRU cache of parsed public keys
+ *
+ *
+ * Note        : This is a pure C++ RSA educational module. No 3rd-party libs used.
+ *
+ * Usage       : #include "RSA.hpp" — RSA.cpp is the demo
+ *
+ * License     : Public Domain / MIT — use it, break it, improve it 👨‍💻
+ *
+ * Last Updated: 20 June 2025
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../Common/ThreadPool.hpp"
+#include "../Hashing Algorithms/SHA256.hpp"
+#include "../Symmetric Key Cryptography/AES.hpp"
+#include "BigNum.hpp"
+
+/*----------------------------------------------------🎲 Random Number + Prime Generator ----------------------------------------------------*/
+// Small ints: trial division. Big primes: random odd start, sieve a window of candidates against the first
+// SMALL_PRIMES primes, then Miller-Rabin on the survivors, with several threads searching their own windows.
+class RandomNo {
+ public:
+   static constexpr size_t SMALL_PRIMES = 2048; // Sieve primes (3 .. 17881)
+   static constexpr size_t SIEVE_WINDOW = 4096; // Odd candidates per window (~11 primes expected at 1024 bits)
+
+   //  Every draw (small ints, Miller-Rabin bases, prime candidates, padding) comes from this thread's AES CTR_DRBG
+   static aes::CtrDrbg &engine() { return aes::rng(); }
+
+   //  Padding bytes (OAEP seeds, PKCS#1 v1.5 filler); nonZero redraws 0x00 bytes
+   static void randomBytes(uint8_t *out, size_t len, bool nonZero = false) {
+      aes::randomBytes(out, len);
+      for (size_t i = 0; nonZero && i < len; i++)
+         while (!out[i])
+            aes::randomBytes(out + i, 1);
+   }
+
+   int generateRandom(int r1, int r2) {
+      std::uniform_int_distribution<> distr(r1, r2);
+      return distr(engine());
+   }
+
+   bool isPrime(int n) {
+      if (n <= 1)
+         return false;
+      if (n <= 3)
+         return true;
+      if (n % 2 == 0 || n % 3 == 0)
+         return false;
+      for (int i = 5; i * i <= n; i += 6)
+         if (n % i == 0 || n % (i + 2) == 0)
+            return false;
+      return true;
+   }
+
+   int generateRandomPrime(int lower, int upper) {
+      std::uniform_int_distribution<> distr(lower, upper);
+      int prime;
+      do {
+         prime = distr(engine());
+      } while (!isPrime(prime));
+      return prime;
+   }
+
+   //  Odd primes 3, 5, 7, ... (SMALL_PRIMES of them), sieved once
+   static const std::vector<uint32_t> &smallPrimes() {
+      static const std::vector<uint32_t> primes = [] {
+         std::vector<uint32_t> out;
+         std::vector<bool> composite(20000);
+         for (uint32_t i = 3; out.size() < SMALL_PRIMES; i += 2) {
+            if (composite[i])
+               continue;
+            out.push_back(i);
+            for (uint32_t j = i * i; j < composite.size(); j += 2 * i)
+               composite[j] = true;
+         }
+         return out;
+      }();
+      return primes;
+   }
+
+   //  Miller-Rabin rounds for a random candidate of this size (error <= 2^-100, after FIPS 186-4 Appendix C.3)
+   static int millerRabinRounds(size_t bits) { return bits >= 1536 ? 4 : bits >= 1024 ? 5 : bits >= 512 ? 7 : 40; }
+
+   //  Miller-Rabin with random bases; n odd and > 3
+   template <size_t B> static bool isProbablePrime(const bn::UInt<B> &n, int rounds) {
+      using Num = bn::UInt<B>;
+      const bn::Montgomery<B> mont(n);
+      const Num nm1 = n - Num(1), one = mont.toMont(Num(1)), minusOne = mont.toMont(nm1);
+      size_t s = 0;
+      while (!nm1.bit(s))
+         s++;
+      const Num d = nm1 >> s;
+      for (int r = 0; r < rounds; r++) {
+         Num a; // base in [2, n - 2]
+         for (size_t i = 0; i < Num::LIMBS; i++)
+            a.limb[i] = engine()();
+         a = a % (n - Num(3)) + Num(2);
+         Num x = mont.toMont(mont.pow(a, d));
+         if (x == one || x == minusOne)
+            continue;
+         bool witness = true;
+         for (size_t i = 1; i < s && witness; i++) {
+            x = mont.mul(x, x);
+            if (x == minusOne)
+               witness = false;
+            else if (x == one)
+               break;
+         }
+         if (witness)
+            return false;
+      }
+      return true;
+   }
+
+   //  Random prime of exactly `bits` bits with the top two bits set (so p * q has 2 * bits bits).
+   //  accept(p) can veto a prime (e.g. gcd(e, p - 1) != 1); threads = 0 uses every hardware thread.
+   template <size_t B>
+   static bn::UInt<B> generateLargePrime(size_t bits, unsigned threads = 0,
+                                         const std::function<bool(const bn::UInt<B> &)> &accept = nullptr) {
+      using Num = bn::UInt<B>;
+      if (bits < 32 || bits > B)
+         throw std::invalid_argument("Prime size must be between 32 bits and the container width!");
+      if (threads == 0)
+         threads = std::max(1u, std::thread::hardware_concurrency());
+      const std::vector<uint32_t> &primes = smallPrimes();
+      const int rounds = millerRabinRounds(bits);
+      std::atomic<bool> found{false};
+      Num result;
+      std::mutex resultLock;
+
+      auto search = [&] {
+         std::vector<uint8_t> composite(SIEVE_WINDOW);
+         while (!found) {
+            Num start;
+            for (size_t i = 0; i < bits; i += 64)
+               start.limb[i / 64] = engine()();
+            start = (start << (B - bits)) >> (B - bits); // keep the low `bits` bits
+            start.setBit(bits - 1);
+            start.setBit(bits - 2);
+            start.limb[0] |= 1;
+
+            // composite[k] marks start + 2k divisible by a small prime: 2k = -start (mod p), 1/2 = (p + 1) / 2
+            std::fill(composite.begin(), composite.end(), 0);
+            for (uint32_t p : primes) {
+               Num t = start;
+               uint64_t r = t.divSmall(p);
+               for (uint64_t k = (p - r) % p * ((p + 1) / 2) % p; k < SIEVE_WINDOW; k += p)
+                  composite[k] = 1;
+            }
+            for (size_t k = 0; k < SIEVE_WINDOW && !found; k++) {
+               if (composite[k])
+                  continue;
+               Num candidate = start + Num(2 * k);
+               if (candidate.bitLength() != bits || !isProbablePrime(candidate, rounds) || (accept && !accept(candidate)))
+                  continue;
+               std::lock_guard<std::mutex> lock(resultLock);
+               if (!found) {
+                  result = candidate;
+                  found = true;
+               }
+            }
+         }
+      };
+      std::vector<std::thread> workers;
+      for (unsigned t = 1; t < threads; t++)
+         workers.emplace_back(search);
+      search();
+      for (std::thread &w : workers)
+         w.join();
+      return result;
+   }
+};
+
+/*----------------------------------------------------🔐 RSA Encryption / Decryption Core ----------------------------------------------------*/
+//  Bits = width of the modulus container (RSA<2048>, RSA<3072>, RSA<4096>); every exponentiation runs through
+//  a Montgomery context built once per key. Keys are generated at full size with e = 65537 (or a caller's odd e)
+//  and d = e^-1 mod lambda(n), or imported with RSA(n, e, d) or, for CRT, RSA(n, e, d, p, q).
+template <size_t Bits = 2048> class RSA : private RandomNo {
+   static_assert(Bits >= 64, "RSA modulus container must hold at least 64 bits");
+
+ public:
+   using Num = bn::UInt<Bits>;
+   static constexpr size_t HALF_BITS = Bits / 2 < 64 ? 64 : (Bits / 2 + 63) / 64 * 64; // Room for p and q
+   using HalfNum = bn::UInt<HALF_BITS>;
+
+ private:
+   Num privateKey, publicKey, product;
+   std::optional<bn::Montgomery<Bits>> mont;
+   std::optional<bn::MontgomeryX4<Bits>> lanes; // Same modulus, four messages at a time (batch public operations)
+
+   // CRT form of the private key: dP = d mod (p - 1), dQ = d mod (q - 1), qInv = q^-1 mod p
+   HalfNum p, q, dP, dQ, qInv;
+   std::optional<bn::Montgomery<HALF_BITS>> montP, montQ;
+
+   //  Fills the CRT parameters from n, d and the factors (p, q prime, p * q == n)
+   void setCrt(const HalfNum &P, const HalfNum &Q) {
+      if (P == Q || P <= HalfNum(1) || Q <= HalfNum(1) || P.mulWide(Q) != bn::UInt<2 * HALF_BITS>(product))
+         throw std::invalid_argument("RSA primes must be distinct and multiply to the modulus!");
+      p = P;
+      q = Q;
+      montP.emplace(p);
+      montQ.emplace(q);
+      dP = HalfNum(privateKey % Num(p - HalfNum(1)));
+      dQ = HalfNum(privateKey % Num(q - HalfNum(1)));
+      qInv = bn::inverseModOdd(q, p);
+   }
+
+   //  m = c^d mod n through the two half-size exponentiations (Garner recombination), else directly.
+   //  The private exponents only go through powSecret, and the recombination has no branch on m1 / m2.
+   Num privateOp(const Num &c) const {
+      if (privateKey.isZero())
+         throw std::runtime_error("RSA key has no private exponent!");
+      if (c >= product)
+         throw std::invalid_argument("RSA input must be smaller than the modulus!");
+      if (!montP)
+         return mont->powSecret(c, privateKey);
+      bn::UInt<2 * HALF_BITS> wide(c);
+      HalfNum m1 = montP->powSecret(montP->reduce(wide), dP);
+      HalfNum m2 = montQ->powSecret(montQ->reduce(wide), dQ);
+      // h = qInv * (m1 - m2) mod p; m = m2 + q * h
+      HalfNum diff = montP->subMod(m1, montP->mod(m2));
+      HalfNum h = montP->mul(montP->toMont(diff), qInv);
+      Num m = Num(q.mulWide(h)) + Num(m2);
+      // Fault check: a glitch in either half would leak a factor of n (Bellcore attack), so never release it
+      if (mont->pow(m, publicKey) != c)
+         throw std::runtime_error("RSA-CRT fault check failed!");
+      return m;
+   }
+
+   void setModulus() {
+      mont.emplace(product); // rejects even n
+      lanes.emplace(*mont);
+   }
+
+   //  Two primes of modulusBits / 2 bits with gcd(e, p - 1) = 1, then d = e^-1 mod lcm(p - 1, q - 1)
+   void generateKeys(size_t modulusBits, const Num &e, unsigned threads) {
+      if (modulusBits < MIN_MODULUS_BITS || modulusBits > Bits || modulusBits % 2)
+         throw std::invalid_argument("RSA modulus size must be even, at least 64 bits and fit the key container!");
+      if (!e.isOdd() || e < Num(3) || e.bitLength() >= modulusBits)
+         throw std::invalid_argument("RSA public exponent must be odd, at least 3 and shorter than the modulus!");
+      const size_t half = modulusBits / 2;
+      auto coprime = [&](const HalfNum &prime) { return bn::gcd(e, Num(prime - HalfNum(1))) == Num(1); };
+      for (;;) {
+         HalfNum P = generateLargePrime<HALF_BITS>(half, threads, coprime);
+         HalfNum Q = generateLargePrime<HALF_BITS>(half, threads, coprime);
+         // FIPS 186-4 B.3.1: p and q must not be close, and d must not be small (both near-certain for random primes)
+         HalfNum gap = P > Q ? P - Q : Q - P;
+         if (half > 100 && gap.bitLength() <= half - 100)
+            continue;
+         HalfNum pm1 = P - HalfNum(1), qm1 = Q - HalfNum(1);
+         Num lambda = Num(pm1.mulWide(qm1)) / Num(bn::gcd(pm1, qm1));
+         Num d = bn::inverseMod(e, lambda);
+         if (d.bitLength() <= half)
+            continue;
+         product = Num(P.mulWide(Q));
+         publicKey = e;
+         privateKey = d;
+         setModulus();
+         setCrt(P, Q);
+         return;
+      }
+   }
+
+ public:
+   static constexpr size_t MIN_MODULUS_BITS = 64;
+   static constexpr uint64_t DEFAULT_EXPONENT = 65537;
+
+   //  Full-size (Bits) key with e = 65537, printed like the original demo
+   RSA() {
+      generateKeys(Bits, Num(DEFAULT_EXPONENT), 0);
+      std::cout << "\nPublic Key: " << publicKey;
+      std::cout << "\nPrivate Key: " << privateKey << std::endl;
+   }
+
+   //  Quiet keygen with a modulus of exactly modulusBits bits; threads = 0 searches primes on every hardware thread
+   explicit RSA(size_t modulusBits, const Num &e = Num(DEFAULT_EXPONENT), unsigned threads = 0) {
+      generateKeys(modulusBits, e, threads);
+   }
+
+   //  Imported key: modulus n, public exponent e, private exponent d
+   RSA(const Num &n, const Num &e, const Num &d) : privateKey(d), publicKey(e), product(n) {
+      if (e.isZero() || d.isZero() || e >= n || d >= n)
+         throw std::invalid_argument("RSA exponents must be between 1 and n - 1!");
+      setModulus();
+   }
+   //  Public key only (n, e): encrypt and verify, e.g. on a verification server; private operations throw
+   RSA(const Num &n, const Num &e) : publicKey(e), product(n) {
+      if (e.isZero() || e >= n)
+         throw std::invalid_argument("RSA public exponent must be between 1 and n - 1!");
+      setModulus();
+   }
+   //  Imported key with its factors: private operations use the CRT
+   RSA(const Num &n, const Num &e, const Num &d, const HalfNum &p, const HalfNum &q) : RSA(n, e, d) { setCrt(p, q); }
+
+   const Num &modulus() const { return product; }
+   const Num &exponent() const { return publicKey; }
+   //  Private parts, for saving a generated key (zero / empty on a public-only key)
+   const Num &privateExponent() const { return privateKey; }
+   const HalfNum &primeP() const { return p; }
+   const HalfNum &primeQ() const { return q; }
+
+   static Num modular_pow(const Num &base, const Num &exp, const Num &mod) { return bn::powMod(base, exp, mod); }
+
+   //  Raw RSA on one integer m < n (RSAEP / RSADP)
+   Num encryptBlock(const Num &m) const {
+      if (m >= product)
+         throw std::invalid_argument("RSA input must be smaller than the modulus!");
+      return mont->pow(m, publicKey);
+   }
+   Num decryptBlock(const Num &c) const { return privateOp(c); }
+
+   //  Raw signature primitives on a message representative m < n (RSASP1 / RSAVP1)
+   Num sign(const Num &m) const { return privateOp(m); }
+   bool verify(const Num &m, const Num &s) const { return s < product && mont->pow(s, publicKey) == m; }
+   bool usesCrt() const { return montP.has_value(); }
+   bool hasPrivateKey() const { return !privateKey.isZero(); }
+
+   /*----------------------------------------------------Batch Public-Key Operations----------------------------------------------------*/
+   //  Many messages under one key: every worker shares this key's Montgomery contexts, messages go four at a time
+   //  through the AVX2 lanes (scalar without AVX2), and BATCH_CHUNK messages make one task for the pool.
+   //  Inputs are checked on the calling thread first, so a bad one throws before any work starts.
+   static constexpr size_t BATCH_CHUNK = 32;
+
+   //  out[i] = in[i]^e mod n (RSAEP); in and out may be the same array
+   void encryptBatch(const Num *in, Num *out, size_t count, lab::ThreadPool &pool = lab::defaultPool()) const {
+      for (size_t i = 0; i < count; i++)
+         if (in[i] >= product)
+            throw std::invalid_argument("RSA input must be smaller than the modulus!");
+      publicBatch(in, count, pool, [&](size_t i, const Num &c) { out[i] = c; });
+   }
+
+   //  ok[i] = verify(m[i], s[i]); returns how many signatures verified
+   size_t verifyBatch(const Num *m, const Num *s, bool *ok, size_t count, lab::ThreadPool &pool = lab::defaultPool()) const {
+      std::atomic<size_t> good{0};
+      publicBatch(s, count, pool, [&](size_t i, const Num &v) {
+         ok[i] = s[i] < product && v == m[i];
+         if (ok[i])
+            good.fetch_add(1, std::memory_order_relaxed);
+      });
+      return good.load();
+   }
+
+   /*----------------------------------------------------Padding (PKCS#1 v2.2)----------------------------------------------------*/
+   //  Every padded operation takes and returns exactly modulusBytes() bytes of ciphertext; OAEP carries up to
+   //  k - 66 message bytes per block (SHA-256), PKCS#1 v1.5 up to k - 11. New code should use OAEP: v1.5
+   //  decryption is only here for compatibility and is a padding oracle if its errors ever reach an attacker.
+   enum class Padding { OAEP, PKCS1v15 };
+   static constexpr size_t OAEP_OVERHEAD = 2 * SHA256::DIGEST_SIZE + 2;
+   static constexpr size_t PKCS1_OVERHEAD = 11;
+
+   size_t modulusBytes() const { return (product.bitLength() + 7) / 8; }
+   size_t maxMessageBytes(Padding pad = Padding::OAEP) const {
+      size_t k = modulusBytes(), overhead = pad == Padding::OAEP ? OAEP_OVERHEAD : PKCS1_OVERHEAD;
+      return k > overhead ? k - overhead : 0;
+   }
+
+   //  RSAES-OAEP-ENCRYPT with SHA-256 and MGF1-SHA-256: len <= maxMessageBytes(), out receives k bytes
+   void encryptOAEP(const uint8_t *msg, size_t len, uint8_t *out, const std::string &label = "") const {
+      const size_t k = modulusBytes(), hLen = SHA256::DIGEST_SIZE;
+      if (k < OAEP_OVERHEAD || len > k - OAEP_OVERHEAD)
+         throw std::invalid_argument("Message too long for RSA-OAEP!");
+      // EM = 0x00 || maskedSeed || maskedDB, DB = lHash || PS (zeros) || 0x01 || M
+      std::array<uint8_t, Bits / 8> em{};
+      uint8_t *seed = em.data() + 1, *db = seed + hLen;
+      const size_t dbLen = k - hLen - 1;
+      SHA256::Digest lHash = SHA256::hash(label);
+      std::copy(lHash.begin(), lHash.end(), db);
+      db[dbLen - len - 1] = 0x01;
+      std::copy(msg, msg + len, db + dbLen - len);
+      randomBytes(seed, hLen);
+      mgf1Xor(seed, hLen, db, dbLen);
+      mgf1Xor(db, dbLen, seed, hLen);
+      encryptBlock(Num::fromBytes(em.data(), k)).toBytes(out, k);
+   }
+
+   //  RSAES-OAEP-DECRYPT: in is k bytes, out needs maxMessageBytes() of room; returns the message length.
+   //  Every malformed block fails with the same exception after the same work (no Manger oracle).
+   size_t decryptOAEP(const uint8_t *in, uint8_t *out, const std::string &label = "") const {
+      const size_t k = modulusBytes(), hLen = SHA256::DIGEST_SIZE;
+      if (k < OAEP_OVERHEAD)
+         throw std::invalid_argument("RSA modulus too small for OAEP!");
+      std::array<uint8_t, Bits / 8> em{};
+      decodeBlock(in, em.data(), k);
+      uint8_t *seed = em.data() + 1, *db = seed + hLen;
+      const size_t dbLen = k - hLen - 1;
+      mgf1Xor(db, dbLen, seed, hLen);
+      mgf1Xor(seed, hLen, db, dbLen);
+      SHA256::Digest lHash = SHA256::hash(label);
+      uint8_t bad = em[0];
+      for (size_t i = 0; i < hLen; i++)
+         bad |= db[i] ^ lHash[i];
+      // First 0x01 after the zero run marks the message; anything else before it is an error
+      size_t start = 0;
+      uint8_t found = 0;
+      for (size_t i = hLen; i < dbLen; i++) {
+         uint8_t isOne = db[i] == 1, isZero = db[i] == 0, take = isOne & (found ^ 1);
+         start |= (i + 1) & (0 - (size_t)take);
+         bad |= (found ^ 1) & (isOne ^ 1) & (isZero ^ 1);
+         found |= isOne;
+      }
+      if (bad | (found ^ 1))
+         throw std::invalid_argument("RSA decryption error!");
+      std::copy(db + start, db + dbLen, out);
+      return dbLen - start;
+   }
+
+   //  RSAES-PKCS1-v1_5-ENCRYPT: EM = 0x00 || 0x02 || PS (>= 8 random non-zero bytes) || 0x00 || M
+   void encryptPKCS1v15(const uint8_t *msg, size_t len, uint8_t *out) const {
+      const size_t k = modulusBytes();
+      if (k < PKCS1_OVERHEAD || len > k - PKCS1_OVERHEAD)
+         throw std::invalid_argument("Message too long for RSA PKCS#1 v1.5!");
+      std::array<uint8_t, Bits / 8> em{};
+      em[1] = 0x02;
+      randomBytes(em.data() + 2, k - len - 3, true);
+      std::copy(msg, msg + len, em.data() + k - len);
+      encryptBlock(Num::fromBytes(em.data(), k)).toBytes(out, k);
+   }
+
+   //  RSAES-PKCS1-v1_5-DECRYPT: in is k bytes, out needs maxMessageBytes(Padding::PKCS1v15); returns the length
+   size_t decryptPKCS1v15(const uint8_t *in, uint8_t *out) const {
+      const size_t k = modulusBytes();
+      if (k < PKCS1_OVERHEAD)
+         throw std::invalid_argument("RSA modulus too small for PKCS#1 v1.5!");
+      std::array<uint8_t, Bits / 8> em{};
+      decodeBlock(in, em.data(), k);
+      uint8_t bad = em[0] | (em[1] ^ 0x02);
+      size_t sep = 0;
+      uint8_t found = 0;
+      for (size_t i = 2; i < k; i++) {
+         uint8_t isZero = em[i] == 0, take = isZero & (found ^ 1);
+         sep |= i & (0 - (size_t)take);
+         found |= isZero;
+      }
+      if (bad | (found ^ 1) | (sep < 10))
+         throw std::invalid_argument("RSA decryption error!");
+      std::copy(em.data() + sep + 1, em.data() + k, out);
+      return k - sep - 1;
+   }
+
+   /*----------------------------------------------------Whole Messages----------------------------------------------------*/
+   //  Messages longer than one block are cut into maxMessageBytes() chunks, one k-byte block each. The blocks are
+   //  independent (they can be dropped or reordered), so bulk data belongs under a symmetric cipher instead.
+   size_t ciphertextSize(size_t len, Padding pad = Padding::OAEP) const {
+      size_t chunk = maxMessageBytes(pad);
+      if (!chunk)
+         throw std::invalid_argument("RSA modulus too small for this padding!");
+      return std::max<size_t>(1, (len + chunk - 1) / chunk) * modulusBytes(); // an empty message still gets one block
+   }
+   //  Largest plaintext a ciphertext of len bytes can hold (the output size decrypt() needs)
+   size_t plaintextCapacity(size_t len, Padding pad = Padding::OAEP) const { return len / modulusBytes() * maxMessageBytes(pad); }
+
+   //  Encrypts into a caller-owned buffer of at least ciphertextSize(len) bytes; returns the bytes written
+   size_t encrypt(const uint8_t *in, size_t len, uint8_t *out, size_t outLen, Padding pad = Padding::OAEP) const {
+      const size_t k = modulusBytes(), chunk = maxMessageBytes(pad), total = ciphertextSize(len, pad);
+      if (outLen < total)
+         throw std::invalid_argument("RSA output buffer too small!");
+      size_t off = 0;
+      do {
+         size_t n = std::min(chunk, len - off);
+         if (pad == Padding::OAEP)
+            encryptOAEP(in + off, n, out);
+         else
+            encryptPKCS1v15(in + off, n, out);
+         off += n;
+         out += k;
+      } while (off < len);
+      return total;
+   }
+
+   //  Decrypts whole k-byte blocks into a buffer of at least plaintextCapacity(len) bytes; returns the bytes written
+   size_t decrypt(const uint8_t *in, size_t len, uint8_t *out, size_t outLen, Padding pad = Padding::OAEP) const {
+      const size_t k = modulusBytes();
+      if (len % k)
+         throw std::invalid_argument("RSA ciphertext must be a whole number of blocks!");
+      if (outLen < plaintextCapacity(len, pad))
+         throw std::invalid_argument("RSA output buffer too small!");
+      size_t written = 0;
+      for (size_t off = 0; off < len; off += k)
+         written += pad == Padding::OAEP ? decryptOAEP(in + off, out + written) : decryptPKCS1v15(in + off, out + written);
+      return written;
+   }
+
+   std::vector<uint8_t> encrypt(const std::string &str, Padding pad = Padding::OAEP) const {
+      std::vector<uint8_t> encrypted(ciphertextSize(str.size(), pad));
+      encrypt(reinterpret_cast<const uint8_t *>(str.data()), str.size(), encrypted.data(), encrypted.size(), pad);
+      return encrypted;
+   }
+
+   std::string decrypt(const std::vector<uint8_t> &data, Padding pad = Padding::OAEP) const {
+      std::string result(plaintextCapacity(data.size(), pad), '\0');
+      result.resize(decrypt(data.data(), data.size(), reinterpret_cast<uint8_t *>(&result[0]), result.size(), pad));
+      return result;
+   }
+
+   /*----------------------------------------------------Signatures (RSASSA-PSS)----------------------------------------------------*/
+   //  PKCS#1 v2.2 PSS with SHA-256, MGF1-SHA-256 and a random salt (32 bytes by default, like OpenSSL's
+   //  rsa_pss_saltlen:digest). Every signature is exactly modulusBytes() bytes; signing goes through the CRT with
+   //  its fault check, verifying is one public exponentiation on this key's Montgomery context.
+   static constexpr size_t PSS_SALT = SHA256::DIGEST_SIZE;
+
+   //  RSASSA-PSS-SIGN over an already computed SHA-256 digest; sig receives k bytes
+   void signPSSDigest(const SHA256::Digest &mHash, uint8_t *sig, size_t saltLen = PSS_SALT) const {
+      const size_t k = modulusBytes(), hLen = SHA256::DIGEST_SIZE, emBits = product.bitLength() - 1, emLen = (emBits + 7) / 8;
+      if (emLen < hLen + saltLen + 2)
+         throw std::invalid_argument("RSA modulus too small for PSS with this salt length!");
+      // EM = maskedDB || H || 0xbc, DB = PS (zeros) || 0x01 || salt, H = SHA-256(0^8 || mHash || salt);
+      // EM sits right-aligned in k bytes (one leading zero byte when the modulus is 8m + 1 bits)
+      std::array<uint8_t, Bits / 8> em{};
+      uint8_t *db = em.data() + (k - emLen), *h = db + emLen - hLen - 1, *salt = h - saltLen;
+      const size_t dbLen = emLen - hLen - 1;
+      randomBytes(salt, saltLen);
+      salt[-1] = 0x01;
+      pssHash(mHash, salt, saltLen, h);
+      mgf1Xor(h, hLen, db, dbLen);
+      db[0] &= 0xFF >> (8 * emLen - emBits);
+      h[hLen] = 0xbc;
+      privateOp(Num::fromBytes(em.data(), k)).toBytes(sig, k);
+   }
+
+   //  RSASSA-PSS-VERIFY over a SHA-256 digest; sig is k bytes
+   bool verifyPSSDigest(const SHA256::Digest &mHash, const uint8_t *sig, size_t saltLen = PSS_SALT) const {
+      Num s = Num::fromBytes(sig, modulusBytes());
+      return s < product && pssCheck(mHash, mont->pow(s, publicKey), saltLen);
+   }
+
+   void signPSS(const uint8_t *msg, size_t len, uint8_t *sig, size_t saltLen = PSS_SALT) const {
+      signPSSDigest(SHA256::hash(msg, len), sig, saltLen);
+   }
+   bool verifyPSS(const uint8_t *msg, size_t len, const uint8_t *sig, size_t saltLen = PSS_SALT) const {
+      return verifyPSSDigest(SHA256::hash(msg, len), sig, saltLen);
+   }
+
+   std::vector<uint8_t> signPSS(const std::string &str) const {
+      std::vector<uint8_t> sig(modulusBytes());
+      signPSS(reinterpret_cast<const uint8_t *>(str.data()), str.size(), sig.data());
+      return sig;
+   }
+   bool verifyPSS(const std::string &str, const std::vector<uint8_t> &sig) const {
+      return sig.size() == modulusBytes() && verifyPSS(reinterpret_cast<const uint8_t *>(str.data()), str.size(), sig.data());
+   }
+
+   //  Many signatures under this key: ok[i] = verifyPSSDigest(mHash[i], sig[i]), each sig[i] k bytes. The public
+   //  exponentiations run through publicBatch (pool + AVX2 lanes); returns how many verified.
+   size_t verifyPSSDigests(const SHA256::Digest *mHash, const uint8_t *const sig[], bool *ok, size_t count,
+                           lab::ThreadPool &pool = lab::defaultPool(), size_t saltLen = PSS_SALT) const {
+      const size_t k = modulusBytes();
+      std::vector<Num> s(count);
+      for (size_t i = 0; i < count; i++)
+         s[i] = Num::fromBytes(sig[i], k);
+      std::atomic<size_t> good{0};
+      publicBatch(s.data(), count, pool, [&](size_t i, const Num &m) {
+         ok[i] = s[i] < product && pssCheck(mHash[i], m, saltLen);
+         if (ok[i])
+            good.fetch_add(1, std::memory_order_relaxed);
+      });
+      return good.load();
+   }
+
+   //  Same over whole messages: the digests come from SHA256::hashMany (SHA-NI or multi-buffer lanes) first
+   size_t verifyPSSBatch(const uint8_t *const msg[], const size_t len[], const uint8_t *const sig[], bool *ok, size_t count,
+                         lab::ThreadPool &pool = lab::defaultPool(), size_t saltLen = PSS_SALT) const {
+      std::vector<SHA256::Digest> mHash(count);
+      SHA256::hashMany(msg, len, mHash.data(), count);
+      return verifyPSSDigests(mHash.data(), sig, ok, count, pool, saltLen);
+   }
+
+ private:
+   //  sink(i, in[i]^e mod n) for every i; an input >= n is exponentiated as 0 (callers reject or flag it)
+   template <class Sink> void publicBatch(const Num *in, size_t count, lab::ThreadPool &pool, Sink &&sink) const {
+      const size_t tasks = (count + BATCH_CHUNK - 1) / BATCH_CHUNK;
+      pool.parallelFor(tasks, [&](size_t task) {
+         constexpr size_t W = bn::MontgomeryX4<Bits>::LANES;
+         const size_t end = std::min(count, (task + 1) * BATCH_CHUNK);
+         for (size_t i = task * BATCH_CHUNK; i < end; i += W) {
+            const size_t used = std::min(W, end - i);
+            Num base[W], result[W];
+            for (size_t l = 0; l < used; l++)
+               base[l] = in[i + l] < product ? in[i + l] : Num();
+            lanes->pow(base, publicKey, result, *mont, used);
+            for (size_t l = 0; l < used; l++)
+               sink(i + l, result[l]);
+         }
+      });
+   }
+
+   //  c (k bytes) -> EM = I2OSP(RSADP(c), k)
+   void decodeBlock(const uint8_t *in, uint8_t *em, size_t k) const {
+      Num c = Num::fromBytes(in, k);
+      if (c >= product)
+         throw std::invalid_argument("RSA decryption error!");
+      privateOp(c).toBytes(em, k);
+   }
+
+   //  H = SHA-256(0x00 * 8 || mHash || salt)
+   static void pssHash(const SHA256::Digest &mHash, const uint8_t *salt, size_t saltLen, uint8_t *h) {
+      static const uint8_t zeros[8] = {};
+      SHA256().update(zeros, 8).update(mHash.data(), mHash.size()).update(salt, saltLen).final(h);
+   }
+
+   //  EMSA-PSS-VERIFY on m = s^e mod n (public data, so the early exits leak nothing)
+   bool pssCheck(const SHA256::Digest &mHash, const Num &m, size_t saltLen) const {
+      const size_t k = modulusBytes(), hLen = SHA256::DIGEST_SIZE, emBits = product.bitLength() - 1, emLen = (emBits + 7) / 8;
+      if (emLen < hLen + saltLen + 2)
+         return false;
+      std::array<uint8_t, Bits / 8> em{};
+      m.toBytes(em.data(), k);
+      uint8_t *db = em.data() + (k - emLen), *h = db + emLen - hLen - 1;
+      const size_t dbLen = emLen - hLen - 1;
+      const uint8_t topMask = 0xFF >> (8 * emLen - emBits);
+      if ((k > emLen && em[0]) || h[hLen] != 0xbc || (db[0] & ~topMask))
+         return false;
+      mgf1Xor(h, hLen, db, dbLen);
+      db[0] &= topMask;
+      const size_t psLen = dbLen - saltLen - 1;
+      for (size_t i = 0; i < psLen; i++)
+         if (db[i])
+            return false;
+      if (db[psLen] != 0x01)
+         return false;
+      uint8_t expected[SHA256::DIGEST_SIZE];
+      pssHash(mHash, db + psLen + 1, saltLen, expected);
+      return std::equal(expected, expected + hLen, h);
+   }
+
+   //  out ^= MGF1-SHA-256(seed, len)
+   static void mgf1Xor(const uint8_t *seed, size_t seedLen, uint8_t *out, size_t len) {
+      SHA256 h;
+      uint8_t counter[4], mask[SHA256::DIGEST_SIZE];
+      for (uint32_t c = 0; len; c++) {
+         counter[0] = (uint8_t)(c >> 24);
+         counter[1] = (uint8_t)(c >> 16);
+         counter[2] = (uint8_t)(c >> 8);
+         counter[3] = (uint8_t)c;
+         h.update(seed, seedLen).update(counter, 4).final(mask);
+         size_t n = std::min(len, sizeof(mask));
+         for (size_t i = 0; i < n; i++)
+            out[i] ^= mask[i];
+         out += n;
+         len -= n;
+      }
+   }
+};
+
+/*----------------------------------------------------🗂️ Public-Key Cache ----------------------------------------------------*/
+//  Parsed public keys by fingerprint, SHA-256(I2OSP(n, Bits / 8) || I2OSP(e, Bits / 8)), least recently used
+//  evicted first. A cached RSA already holds its Montgomery constants (-n^-1 mod 2^64, R^2 mod n) and the AVX2
+//  lane context, so verifying against a key seen before costs the exponentiation and nothing else. Entries are
+//  shared, so a key evicted while another thread still verifies with it stays alive until that thread is done.
+//  Thread-safe: one lock around the lookup; building a new key and every exponentiation run outside it.
+template <size_t Bits = 2048> class PublicKeyCache {
+ public:
+   using Key = RSA<Bits>;
+   using Num = typename Key::Num;
+   using Fingerprint = SHA256::Digest;
+   static constexpr size_t DEFAULT_CAPACITY = 1024;
+
+   explicit PublicKeyCache(size_t capacity = DEFAULT_CAPACITY) : limit(capacity) {
+      if (!capacity)
+         throw std::invalid_argument("Key cache capacity must be at least 1!");
+   }
+
+   static Fingerprint fingerprint(const Num &n, const Num &e) {
+      uint8_t buf[2 * (Bits / 8)];
+      n.toBytes(buf, Bits / 8);
+      e.toBytes(buf + Bits / 8, Bits / 8);
+      return SHA256::hash(buf, sizeof(buf));
+   }
+
+   //  The cached key for (n, e), parsed and inserted on a miss; throws like RSA(n, e) on a bad key.
+   //  Counted once the locked lookup is final: a caller that parsed the key but lost the race to insert it
+   //  gets the cached copy and counts a hit, so misses() is the number of keys actually inserted.
+   std::shared_ptr<const Key> get(const Num &n, const Num &e) {
+      const Fingerprint fp = fingerprint(n, e);
+      {
+         std::lock_guard<std::mutex> lock(guard);
+         if (std::shared_ptr<const Key> key = touch(fp)) {
+            hit++;
+            return key;
+         }
+      }
+      auto fresh = std::make_shared<const Key>(n, e); // parsed outside the lock
+      std::lock_guard<std::mutex> lock(guard);
+      if (std::shared_ptr<const Key> key = touch(fp)) { // another thread parsed it first
+         hit++;
+         return key;
+      }
+      missed++;
+      order.emplace_front(fp, fresh);
+      index.emplace(fp, order.begin());
+      if (order.size() > limit) {
+         index.erase(order.back().first);
+         order.pop_back();
+         evicted++;
+      }
+      return fresh;
+   }
+
+   //  The cached key with this fingerprint, or null (counts as a hit or a miss)
+   std::shared_ptr<const Key> find(const Fingerprint &fp) {
+      std::lock_guard<std::mutex> lock(guard);
+      std::shared_ptr<const Key> key = touch(fp);
+      if (key)
+         hit++;
+      else
+         missed++;
+      return key;
+   }
+
+   //  One signature against a key that is usually already cached
+   bool verifyPSS(const Num &n, const Num &e, const uint8_t *msg, size_t len, const uint8_t *sig) {
+      return get(n, e)->verifyPSS(msg, len, sig);
+   }
+
+   void clear() {
+      std::lock_guard<std::mutex> lock(guard);
+      index.clear();
+      order.clear();
+   }
+   size_t size() const {
+      std::lock_guard<std::mutex> lock(guard);
+      return order.size();
+   }
+   size_t capacity() const { return limit; }
+   size_t hits() const { return hit.load(); }
+   size_t misses() const { return missed.load(); }
+   size_t evictions() const { return evicted.load(); }
+
+ private:
+   struct FingerprintHash {
+      size_t operator()(const Fingerprint &fp) const {
+         size_t h;
+         std::memcpy(&h, fp.data(), sizeof(h)); // already uniform
+         return h;
+      }
+   };
+   using Entry = std::pair<Fingerprint, std::shared_ptr<const Key>>;
+
+   //  Lookup that moves a found key to the front; the caller holds guard
+   std::shared_ptr<const Key> touch(const Fingerprint &fp) {
+      auto it = index.find(fp);
+      if (it == index.end())
+         return nullptr;
+      order.splice(order.begin(), order, it->second);
+      return it->second->second;
+   }
+
+   const size_t limit;
+   mutable std::mutex guard;
+   std::list<Entry> order; // most recently used first
+   std::unordered_map<Fingerprint, typename std::list<Entry>::iterator, FingerprintHash> index;
+   std::atomic<size_t> hit{0}, missed{0}, evicted{0};
+};
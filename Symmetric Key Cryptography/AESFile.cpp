@@ -0,0 +1,514 @@
+/*----------------------------------------------------AES File Encryption Tool 🔐 ----------------------------------------------------*/
+/* Author      : Hassan (a.k.a. The Eagle 🦅)
+ * Description : Encrypts / decrypts whole files or pipes with AES-GCM (AES-128/192/256, picked by key length).
+ *               - Regular files are memory-mapped and encrypted straight from the input map into the output map,
+ *                 spread over the thread pool (zero copy, no per-block I/O)
+ *               - Pipes are read in large page-aligned chunks that are encrypted in place and written back out
+ *               - One buffer allocation per run; throughput goes to stderr
+ *               - Hybrid mode: a fresh AES-256 session key per file, wrapped once with the recipient's RSA-OAEP key
+ *
+ * Format      : v1: "EAGLEGCM" | 1 | key bytes | 2 reserved | 12-byte nonce | ciphertext | 16-byte tag
+ *               v2: "EAGLEGCM" | 2 | key bytes | wrapped key length (2, big-endian) | 12-byte nonce |
+ *                   RSA-OAEP wrapped session key | ciphertext | 16-byte tag
+ *               The whole header (24 bytes, plus the wrapped key in v2) is authenticated as AAD, so it cannot be
+ *               edited without failing the tag.
+ *
+ * Usage       : ./AESFile encrypt (-k <hex key> | -K <file with hex key> | -r <RSA public key>) [-t threads] <input|-> <output|->
+ *               ./AESFile decrypt (-k <hex key> | -K <file with hex key> | -R <RSA private key>) [-t threads] <input|-> <output|->
+ *               ./AESFile keygen [-b 2048|3072|4096] [-t threads] [-f] <name>   (writes name.pub, and name.key as 0600;
+ *               an existing pair is only replaced with -f)
+ *               On a tag mismatch the output file is deleted; when writing to stdout the exit status is 1 and
+ *               whatever was written must be discarded.
+ *
+ * Build       : g++ -std=c++17 -O2 -pthread AESFile.cpp -o AESFile
+ *
+ * License     : Public Domain / MIT — use it, break it, improve it 👨‍💻
+ */
+
+#include "AES.hpp"
+#include "../Public Key Cryptogrphy/RSA.hpp"
+#include <cctype>
+#include <cerrno>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using std::cerr;
+using std::endl;
+
+/*----------------------------------------------------File Format----------------------------------------------------*/
+constexpr size_t HEADER_SIZE = 24, TAG_SIZE = 16; // Fixed header; v2 appends the wrapped key to it
+constexpr size_t STREAM_CHUNK = 8 << 20; // Pipe buffer: a multiple of PARALLEL_CHUNK, so every worker gets full slices
+constexpr size_t POPULATE_LIMIT = size_t(1) << 30;
+const uint8_t MAGIC[8] = {'E', 'A', 'G', 'L', 'E', 'G', 'C', 'M'};
+
+/*----------------------------------------------------POSIX Helpers----------------------------------------------------*/
+static std::runtime_error ioError(const std::string &what) { return std::runtime_error(what + ": " + strerror(errno)); }
+
+//  read() until len bytes or end of input; returns the count
+static size_t readFull(int fd, uint8_t *buf, size_t len) {
+   size_t got = 0;
+   while (got < len) {
+      ssize_t n = read(fd, buf + got, len - got);
+      if (n < 0 && errno == EINTR)
+         continue;
+      if (n < 0)
+         throw ioError("read");
+      if (n == 0)
+         break;
+      got += n;
+   }
+   return got;
+}
+static void writeFull(int fd, const uint8_t *buf, size_t len) {
+   while (len) {
+      ssize_t n = write(fd, buf, len);
+      if (n < 0 && errno == EINTR)
+         continue;
+      if (n < 0)
+         throw ioError("write");
+      buf += n, len -= n;
+   }
+}
+
+//  An open file descriptor, mapped when it is a regular file (reading) or once sized (writing)
+class FileMap {
+ public:
+   FileMap(const std::string &path, bool output) : path(path), output(output) {
+      if (path == "-") {
+         fd = output ? STDOUT_FILENO : STDIN_FILENO;
+         return;
+      }
+      fd = output ? open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600) : open(path.c_str(), O_RDONLY);
+      if (fd < 0)
+         throw ioError(path);
+      struct stat st;
+      if (fstat(fd, &st) < 0)
+         throw ioError(path);
+      regular = S_ISREG(st.st_mode);
+      device = st.st_dev, inode = st.st_ino;
+      if (regular && !output && st.st_size > 0)
+         mapRange((size_t)st.st_size, PROT_READ, MAP_PRIVATE);
+   }
+   ~FileMap() {
+      if (data)
+         munmap(data, size);
+      if (fd > STDERR_FILENO)
+         close(fd);
+   }
+   FileMap(const FileMap &) = delete;
+   FileMap &operator=(const FileMap &) = delete;
+
+   //  Output only: grows the file to len bytes and maps it for writing
+   void mapForWrite(size_t len) {
+      if (ftruncate(fd, (off_t)len) < 0)
+         throw ioError(path);
+      posix_fallocate(fd, 0, (off_t)len); // reserve blocks up front where supported, not page by page on fault
+      if (len)
+         mapRange(len, PROT_READ | PROT_WRITE, MAP_SHARED);
+   }
+   //  Output only: drops a result that failed authentication
+   void discard() {
+      if (regular && output) {
+         if (ftruncate(fd, 0) < 0 || unlink(path.c_str()) < 0)
+            throw ioError(path);
+      }
+   }
+
+   int fd = -1;
+   bool regular = false; // regular file (size known, mappable)
+   dev_t device = 0;
+   ino_t inode = 0;
+   uint8_t *data = nullptr;
+   size_t size = 0;
+
+ private:
+   std::string path;
+   bool output;
+
+   void mapRange(size_t len, int prot, int flags) {
+      // Up to POPULATE_LIMIT the whole range is faulted in by one call; beyond that (archives larger than RAM)
+      // pages stream through on demand with kernel read-ahead
+      void *p = mmap(nullptr, len, prot, flags | (len <= POPULATE_LIMIT ? MAP_POPULATE : 0), fd, 0);
+      if (p == MAP_FAILED)
+         throw ioError(path);
+      madvise(p, len, MADV_SEQUENTIAL);
+      data = (uint8_t *)p, size = len;
+   }
+};
+
+//  Page-aligned scratch buffer, allocated once
+struct AlignedBuffer {
+   explicit AlignedBuffer(size_t len) : data((uint8_t *)std::aligned_alloc(4096, len)) {
+      if (!data)
+         throw std::bad_alloc();
+   }
+   ~AlignedBuffer() { std::free(data); }
+   uint8_t *data;
+};
+
+/*----------------------------------------------------Encrypt / Decrypt----------------------------------------------------*/
+//  Fixed part of the header; version 2 also records the wrapped key length (the key itself follows the nonce)
+static std::vector<uint8_t> makeHeader(int keyBits, size_t wrappedLen = 0) {
+   std::vector<uint8_t> header(HEADER_SIZE);
+   memcpy(header.data(), MAGIC, sizeof(MAGIC));
+   header[8] = wrappedLen ? 2 : 1;
+   header[9] = (uint8_t)(keyBits / 8);
+   header[10] = (uint8_t)(wrappedLen >> 8);
+   header[11] = (uint8_t)wrappedLen;
+   aes::randomBytes(header.data() + 12, 12); // Fresh 96-bit nonce per file
+   return header;
+}
+
+//  Reads and checks the header, including the wrapped key of a version 2 file
+static std::vector<uint8_t> readHeader(FileMap &in) {
+   std::vector<uint8_t> header(HEADER_SIZE);
+   auto take = [&](size_t from, size_t len) {
+      if (in.regular) {
+         if (in.size < from + len + TAG_SIZE)
+            throw std::invalid_argument("Input is too short to be an encrypted file!");
+         memcpy(header.data() + from, in.data + from, len);
+      } else if (readFull(in.fd, header.data() + from, len) != len) {
+         throw std::invalid_argument("Input is too short to be an encrypted file!");
+      }
+   };
+   take(0, HEADER_SIZE);
+   if (memcmp(header.data(), MAGIC, sizeof(MAGIC)) != 0 || (header[8] != 1 && header[8] != 2))
+      throw std::invalid_argument("Input is not an AESFile (v1/v2) container!");
+   if (header[8] == 2) {
+      size_t wrappedLen = (size_t)header[10] << 8 | header[11];
+      if (wrappedLen == 0)
+         throw std::invalid_argument("Input has an empty wrapped key!");
+      header.resize(HEADER_SIZE + wrappedLen);
+      take(HEADER_SIZE, wrappedLen);
+   }
+   return header;
+}
+
+//  Returns the number of plaintext bytes processed
+template <int KeyBits>
+static uint64_t encryptFile(const aes::KeySchedule<KeyBits> &ks, const std::vector<uint8_t> &header, FileMap &in, FileMap &out,
+                            aes::ThreadPool &pool) {
+   uint8_t tag[TAG_SIZE];
+   aes::GCM gcm(ks);
+   gcm.start(header.data() + 12);
+   gcm.aad(header.data(), header.size());
+
+   if (in.regular && out.regular) { // map to map
+      const size_t len = in.size;
+      out.mapForWrite(header.size() + len + TAG_SIZE);
+      memcpy(out.data, header.data(), header.size());
+      gcm.encryptParallel(in.data, out.data + header.size(), len, pool);
+      gcm.finish(out.data + header.size() + len);
+      return len;
+   }
+   // Streaming: chunks are encrypted in place (or from the input map) into one aligned buffer
+   AlignedBuffer buf(STREAM_CHUNK);
+   writeFull(out.fd, header.data(), header.size());
+   uint64_t total = 0;
+   for (size_t n = STREAM_CHUNK; n == STREAM_CHUNK; total += n) {
+      if (in.regular) {
+         n = std::min(STREAM_CHUNK, (size_t)(in.size - total));
+         gcm.encryptParallel(in.data + total, buf.data, n, pool);
+      } else {
+         n = readFull(in.fd, buf.data, STREAM_CHUNK);
+         gcm.encryptParallel(buf.data, buf.data, n, pool);
+      }
+      writeFull(out.fd, buf.data, n);
+   }
+   gcm.finish(tag);
+   writeFull(out.fd, tag, TAG_SIZE);
+   return total;
+}
+
+//  header comes from readHeader (a pipe has already been read past it)
+template <int KeyBits>
+static uint64_t decryptFile(const aes::KeySchedule<KeyBits> &ks, const std::vector<uint8_t> &header, FileMap &in, FileMap &out,
+                            aes::ThreadPool &pool) {
+   if (header[9] != KeyBits / 8)
+      throw std::invalid_argument("Key length does not match the file (AES-" + std::to_string(header[9] * 8) + ")!");
+   const size_t headerLen = header.size();
+   aes::GCM gcm(ks);
+   gcm.start(header.data() + 12);
+   gcm.aad(header.data(), headerLen);
+
+   bool authentic;
+   uint64_t total = 0;
+   if (in.regular && out.regular) { // map to map
+      total = in.size - headerLen - TAG_SIZE;
+      out.mapForWrite(total);
+      gcm.decryptParallel(in.data + headerLen, out.data, total, pool);
+      authentic = gcm.verify(in.data + headerLen + total);
+   } else {
+      // Streaming: the last TAG_SIZE bytes seen are always held back, since only end of input says they are the tag
+      AlignedBuffer buf(STREAM_CHUNK + TAG_SIZE);
+      size_t have = 0;
+      for (bool more = true; more;) {
+         size_t want = STREAM_CHUNK + TAG_SIZE - have, got;
+         if (in.regular) {
+            got = std::min(want, (size_t)(in.size - headerLen - total - have));
+            memcpy(buf.data + have, in.data + headerLen + total + have, got);
+         } else {
+            got = readFull(in.fd, buf.data + have, want);
+         }
+         more = got == want;
+         have += got;
+         if (have < TAG_SIZE)
+            throw std::invalid_argument("Input is too short to be an encrypted file!");
+         size_t body = have - TAG_SIZE;
+         gcm.decryptParallel(buf.data, buf.data, body, pool);
+         writeFull(out.fd, buf.data, body);
+         memmove(buf.data, buf.data + body, TAG_SIZE);
+         have = TAG_SIZE, total += body;
+      }
+      authentic = gcm.verify(buf.data);
+   }
+   if (!authentic) {
+      out.discard();
+      throw std::runtime_error("Authentication failed: wrong key or modified file (output discarded)!");
+   }
+   return total;
+}
+
+/*----------------------------------------------------Hybrid Mode (RSA Key Wrap)----------------------------------------------------*/
+// The RSA step runs once per file, whatever its size: the session key is OAEP-encrypted to the recipient and the
+// payload goes through the same GCM pipeline as a v1 file. Key files are text, one "<field> <hex>" line each:
+// n and e for a public key, plus d, p and q for a private one.
+constexpr size_t SESSION_KEY_BYTES = 32;                 // AES-256
+const std::string WRAP_LABEL = "EAGLEGCM session key"; // OAEP label: a wrapped key only unwraps as one of ours
+
+struct RsaKeyFile {
+   std::string n, e, d, p, q; // hex
+};
+
+static RsaKeyFile readRsaKey(const std::string &path, bool needPrivate) {
+   std::ifstream file(path);
+   if (!file)
+      throw ioError(path);
+   RsaKeyFile key;
+   std::string field, hex;
+   while (file >> field >> hex) {
+      std::string *slot = field == "n" ? &key.n : field == "e" ? &key.e : field == "d" ? &key.d : field == "p" ? &key.p : field == "q" ? &key.q : nullptr;
+      if (!slot)
+         throw std::invalid_argument(path + ": unknown RSA key field '" + field + "'!");
+      *slot = hex;
+   }
+   if (key.n.empty() || key.e.empty() || (needPrivate && (key.d.empty() || key.p.empty() || key.q.empty())))
+      throw std::invalid_argument(path + (needPrivate ? ": not an RSA private key (needs n, e, d, p, q)!" : ": not an RSA key (needs n, e)!"));
+   return key;
+}
+
+//  Written to a fresh temporary (mkstemp: 0600, never an existing inode) that is given its final mode and then
+//  moved into place: rename() replaces an old file, link() refuses to, so a half-written or loosely
+//  permissioned key is never visible under the real name
+static void writeRsaKey(const std::string &path, const std::vector<std::pair<const char *, std::string>> &fields, mode_t perms,
+                        bool overwrite) {
+   std::string tmp = path + ".XXXXXX";
+   int fd = mkstemp(&tmp[0]);
+   if (fd < 0)
+      throw ioError(path);
+   std::string text;
+   for (const auto &f : fields)
+      text += std::string(f.first) + " " + f.second + "\n";
+   try {
+      if (fchmod(fd, perms) != 0)
+         throw ioError(tmp);
+      writeFull(fd, (const uint8_t *)text.data(), text.size());
+      if (fsync(fd) != 0)
+         throw ioError(tmp);
+      if (overwrite ? rename(tmp.c_str(), path.c_str()) != 0 : link(tmp.c_str(), path.c_str()) != 0)
+         throw ioError(path);
+   } catch (...) {
+      close(fd);
+      unlink(tmp.c_str());
+      throw;
+   }
+   close(fd);
+   if (!overwrite)
+      unlink(tmp.c_str());
+}
+
+//  Container width for a modulus: the smallest of RSA<2048>, RSA<3072>, RSA<4096> that holds it
+static size_t rsaContainer(const RsaKeyFile &key) {
+   size_t bits = bn::UInt<4096>::fromHex(key.n).bitLength();
+   return bits <= 2048 ? 2048 : bits <= 3072 ? 3072 : 4096;
+}
+
+template <size_t Bits> static std::vector<uint8_t> wrapKey(const RsaKeyFile &key, const uint8_t *session) {
+   using Num = typename RSA<Bits>::Num;
+   const RSA<Bits> rsa(Num::fromHex(key.n), Num::fromHex(key.e));
+   std::vector<uint8_t> wrapped(rsa.modulusBytes());
+   rsa.encryptOAEP(session, SESSION_KEY_BYTES, wrapped.data(), WRAP_LABEL);
+   return wrapped;
+}
+
+template <size_t Bits> static void unwrapKey(const RsaKeyFile &key, const std::vector<uint8_t> &header, std::vector<uint8_t> &session) {
+   using R = RSA<Bits>;
+   const R rsa(R::Num::fromHex(key.n), R::Num::fromHex(key.e), R::Num::fromHex(key.d), R::HalfNum::fromHex(key.p), R::HalfNum::fromHex(key.q));
+   if (header.size() - HEADER_SIZE != rsa.modulusBytes())
+      throw std::invalid_argument("File was not encrypted to this RSA key (wrapped key size differs)!");
+   session.resize(rsa.maxMessageBytes());
+   try {
+      session.resize(rsa.decryptOAEP(header.data() + HEADER_SIZE, session.data(), WRAP_LABEL));
+   } catch (const std::invalid_argument &) {
+      throw std::runtime_error("Could not unwrap the session key: wrong RSA key or modified file!");
+   }
+   if (session.size() != header[9])
+      throw std::runtime_error("Could not unwrap the session key: wrong RSA key or modified file!");
+}
+
+//  An existing key pair is only replaced with -f; checked before the (slow) prime search, and again by writeRsaKey
+template <size_t Bits> static void keygen(const std::string &name, size_t threads, bool overwrite) {
+   struct stat st;
+   for (const std::string &path : {name + ".key", name + ".pub"})
+      if (!overwrite && lstat(path.c_str(), &st) == 0)
+         throw std::invalid_argument(path + " already exists (use -f to replace it)!");
+   const RSA<Bits> rsa(Bits, typename RSA<Bits>::Num(RSA<Bits>::DEFAULT_EXPONENT), (unsigned)threads);
+   writeRsaKey(name + ".key", {{"n", rsa.modulus().toHex()},
+                               {"e", rsa.exponent().toHex()},
+                               {"d", rsa.privateExponent().toHex()},
+                               {"p", rsa.primeP().toHex()},
+                               {"q", rsa.primeQ().toHex()}},
+               0600, overwrite);
+   writeRsaKey(name + ".pub", {{"n", rsa.modulus().toHex()}, {"e", rsa.exponent().toHex()}}, 0644, overwrite);
+}
+
+/*----------------------------------------------------Command Line----------------------------------------------------*/
+static std::vector<uint8_t> parseHexKey(std::string hex) {
+   hex.erase(std::remove_if(hex.begin(), hex.end(), [](unsigned char c) { return std::isspace(c); }), hex.end());
+   if (hex.size() != 32 && hex.size() != 48 && hex.size() != 64)
+      throw std::invalid_argument("Key must be 32, 48 or 64 hex digits (AES-128/192/256)!");
+   std::vector<uint8_t> key(hex.size() / 2);
+   for (size_t i = 0; i < key.size(); i++) {
+      if (!std::isxdigit((unsigned char)hex[2 * i]) || !std::isxdigit((unsigned char)hex[2 * i + 1]))
+         throw std::invalid_argument("Key must be hexadecimal!");
+      key[i] = (uint8_t)std::stoi(hex.substr(2 * i, 2), nullptr, 16);
+   }
+   return key;
+}
+
+template <int KeyBits>
+static uint64_t run(bool encrypt, const uint8_t *key, const std::vector<uint8_t> &header, FileMap &in, FileMap &out,
+                    aes::ThreadPool &pool) {
+   const aes::KeySchedule<KeyBits> ks(key);
+   return encrypt ? encryptFile(ks, header, in, out, pool) : decryptFile(ks, header, in, out, pool);
+}
+
+static int usage() {
+   cerr << "Usage: AESFile encrypt (-k <hex key> | -K <key file> | -r <RSA public key>) [-t threads] <input|-> <output|->\n"
+        << "       AESFile decrypt (-k <hex key> | -K <key file> | -R <RSA private key>) [-t threads] <input|-> <output|->\n"
+        << "       AESFile keygen [-b 2048|3072|4096] [-t threads] [-f] <name>" << endl;
+   return 2;
+}
+
+int main(int argc, char *argv[]) {
+   if (argc < 2)
+      return usage();
+   const std::string mode = argv[1];
+   if (mode != "encrypt" && mode != "decrypt" && mode != "keygen")
+      return usage();
+   std::string keyHex, rsaKeyPath;
+   size_t threads = 0, rsaBits = 3072;
+   bool force = false;
+   std::vector<std::string> paths;
+   try {
+      for (int i = 2; i < argc; i++) {
+         std::string arg = argv[i];
+         if ((arg == "-k" || arg == "-K" || arg == "-t" || arg == "-r" || arg == "-R" || arg == "-b") && i + 1 == argc)
+            return usage();
+         if (arg == "-k") {
+            keyHex = argv[++i];
+         } else if (arg == "-K") {
+            std::ifstream file(argv[++i]);
+            if (!file)
+               throw ioError(argv[i]);
+            std::getline(file, keyHex);
+         } else if ((arg == "-r" && mode == "encrypt") || (arg == "-R" && mode == "decrypt")) {
+            rsaKeyPath = argv[++i];
+         } else if (arg == "-t") {
+            threads = std::stoul(argv[++i]);
+         } else if (arg == "-b" && mode == "keygen") {
+            rsaBits = std::stoul(argv[++i]);
+         } else if (arg == "-f" && mode == "keygen") {
+            force = true;
+         } else {
+            paths.push_back(arg);
+         }
+      }
+      if (mode == "keygen") {
+         if (paths.size() != 1 || (rsaBits != 2048 && rsaBits != 3072 && rsaBits != 4096))
+            return usage();
+         auto start = std::chrono::steady_clock::now();
+         rsaBits == 2048   ? keygen<2048>(paths[0], threads, force)
+         : rsaBits == 3072 ? keygen<3072>(paths[0], threads, force)
+                           : keygen<4096>(paths[0], threads, force);
+         std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+         cerr << "Wrote RSA-" << rsaBits << " key pair " << paths[0] << ".pub / " << paths[0] << ".key in " << std::fixed
+              << std::setprecision(3) << secs.count() << " s" << endl;
+         return 0;
+      }
+      if (keyHex.empty() == rsaKeyPath.empty() || paths.size() != 2)
+         return usage();
+
+      auto start = std::chrono::steady_clock::now();
+      FileMap in(paths[0], false);
+      struct stat st;
+      if (paths[1] != "-" && stat(paths[1].c_str(), &st) == 0 && in.regular && st.st_dev == in.device &&
+          st.st_ino == in.inode)
+         throw std::invalid_argument("Input and output must be different files!");
+      const bool encrypt = mode == "encrypt";
+
+      // Session key and header: from -k/-K directly (v1), or wrapped to / unwrapped with an RSA key (v2)
+      std::vector<uint8_t> key, header;
+      if (encrypt && !rsaKeyPath.empty()) {
+         RsaKeyFile rsaKey = readRsaKey(rsaKeyPath, false);
+         key.resize(SESSION_KEY_BYTES);
+         RandomNo::randomBytes(key.data(), key.size());
+         size_t bits = rsaContainer(rsaKey);
+         std::vector<uint8_t> wrapped = bits == 2048   ? wrapKey<2048>(rsaKey, key.data())
+                                        : bits == 3072 ? wrapKey<3072>(rsaKey, key.data())
+                                                       : wrapKey<4096>(rsaKey, key.data());
+         header = makeHeader(8 * SESSION_KEY_BYTES, wrapped.size());
+         header.insert(header.end(), wrapped.begin(), wrapped.end());
+      } else if (encrypt) {
+         key = parseHexKey(keyHex);
+         header = makeHeader(8 * (int)key.size());
+      } else {
+         header = readHeader(in);
+         if (header[8] == 2 && rsaKeyPath.empty())
+            throw std::invalid_argument("File was encrypted to an RSA key: decrypt it with -R <RSA private key>!");
+         if (header[8] == 1 && !rsaKeyPath.empty())
+            throw std::invalid_argument("File was encrypted with a plain AES key: decrypt it with -k or -K!");
+         if (rsaKeyPath.empty()) {
+            key = parseHexKey(keyHex);
+         } else {
+            RsaKeyFile rsaKey = readRsaKey(rsaKeyPath, true);
+            size_t bits = rsaContainer(rsaKey);
+            bits == 2048 ? unwrapKey<2048>(rsaKey, header, key) : bits == 3072 ? unwrapKey<3072>(rsaKey, header, key) : unwrapKey<4096>(rsaKey, header, key);
+            std::fill(rsaKey.d.begin(), rsaKey.d.end(), '\0');
+         }
+      }
+      std::fill(keyHex.begin(), keyHex.end(), '\0');
+      FileMap out(paths[1], true);
+      aes::ThreadPool pool(threads);
+
+      uint64_t bytes = key.size() == 16   ? run<128>(encrypt, key.data(), header, in, out, pool)
+                       : key.size() == 24 ? run<192>(encrypt, key.data(), header, in, out, pool)
+                                          : run<256>(encrypt, key.data(), header, in, out, pool);
+      std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+      std::fill(key.begin(), key.end(), 0);
+
+      cerr << (encrypt ? "Encrypted " : "Decrypted ") << bytes << " bytes with AES-" << key.size() * 8 << "-GCM"
+           << (rsaKeyPath.empty() ? "" : " (RSA-OAEP wrapped key)") << " ("
+           << aes::engineName(aes::resolveEngine(aes::Engine::Auto)) << ", " << pool.size() << " threads, "
+           << (in.regular && out.regular ? "mmap" : "streamed") << ") in " << std::fixed << std::setprecision(3)
+           << secs.count() << " s: " << std::setprecision(1) << bytes / std::max(secs.count(), 1e-9) / 1e6 << " MB/s"
+           << endl;
+   } catch (const std::exception &e) {
+      cerr << "Error: " << e.what() << endl;
+      return 1;
+   }
+   return 0;
+}
@@ -1,154 +1,10 @@
-#include <bitset>
-#include <iomanip>
-#include <iostream>
-#include <string>
-#include <vector>
+#include "FeistelCipher.hpp"
 using std::bitset;
 using std::cout;
-using std::endl;
-using std::invalid_argument;
 using std::setw;
 using std::string;
 using std::vector;
 
-#define SIZE 128
-#define HALF_SIZE SIZE / 2
-
-// ------------------ CONVERT STRING TO 128-BIT BITSET[FOR KEYS] ------------------
-bitset<SIZE> stringToBitsetFromChars(const string &input) {
-  bitset<SIZE> result;
-  size_t totalBits = input.size() * 8;
-  if (SIZE < totalBits)
-    throw invalid_argument("Bitset too small for input string!");
-
-  for (size_t i = 0; i < input.size(); ++i) {
-    bitset<8> charBits(input[i]);
-    for (size_t b = 0; b < 8; ++b) {
-      result[(input.size() - 1 - i) * 8 + b] = charBits[b];
-    }
-  }
-  return result;
-}
-
-// ------------------ CONVERT STRING TO 64-BIT BITSET[FOR KEYS] ------------------
-
-bitset<HALF_SIZE> stringToHalfBitsetFromChars(const string &input) {
-  bitset<HALF_SIZE> result;
-  size_t totalBits = input.size() * 8;
-  if (HALF_SIZE < totalBits)
-    throw invalid_argument("Bitset too small for input string!");
-
-  for (size_t i = 0; i < input.size(); ++i) {
-    bitset<8> charBits(input[i]);
-    for (size_t b = 0; b < 8; ++b) {
-      result[(input.size() - 1 - i) * 8 + b] = charBits[b];
-    }
-  }
-  return result;
-}
-
-// ------------------ 128-BIT PRINTING FUNCTION ------------------
-void printBitset(bitset<SIZE> data) {
-  for (size_t i = 0; i < data.size(); ++i) {
-    if (i % 8 == 0)
-      cout << " ";
-    cout << data[i];
-  }
-  cout << endl;
-}
-
-// ------------------ 64-BIT PRINTING FUNCTION ------------------
-void printHalfBitset(bitset<HALF_SIZE> data) {
-  for (size_t i = 0; i < data.size(); ++i) {
-    if (i % 8 == 0)
-      cout << " ";
-    cout << data[i];
-  }
-  cout << endl;
-}
-
-class FeistelCipher {
-private:
-  // ------------------ F(R, K) = R ⊕ K ------------------
-  bitset<HALF_SIZE> Function(bitset<HALF_SIZE> right, bitset<HALF_SIZE> key) {
-    bitset<HALF_SIZE> result;
-    for (int i = 0; i < HALF_SIZE; i++)
-      result[i] = right[i] ^ key[i];
-    return result;
-  }
-
-public:
-  // ------------------ ENCRYPTION FUNCTION ------------------
-  bitset<SIZE> encrypt(bitset<SIZE> data, vector<bitset<HALF_SIZE>> keys) {
-    int rounds = keys.size();
-    bitset<SIZE> result = data;
-
-    bitset<HALF_SIZE> left, right;
-    for (int i = 0; i < HALF_SIZE; i++) {
-      left[i] = result[i];
-      right[i] = result[i + HALF_SIZE];
-    }
-
-    for (int i = 0; i < rounds; i++) {
-      bitset<HALF_SIZE> temp = Function(right, keys[i]);
-      for (int j = 0; j < HALF_SIZE; j++) {
-        temp[j] = temp[j] ^ left[j];
-      }
-
-      left = right;
-      right = temp;
-
-      for (int j = 0; j < HALF_SIZE; j++) {
-        result[j] = left[j];
-        result[j + HALF_SIZE] = right[j];
-      }
-    }
-
-    // Final swap
-    for (int j = 0; j < HALF_SIZE; j++) {
-      result[j] = right[j];
-      result[j + HALF_SIZE] = left[j];
-    }
-
-    return result;
-  }
-
-  // ------------------ DECRYPTION FUNCTION ------------------
-  bitset<SIZE> decrypt(bitset<SIZE> data, vector<bitset<HALF_SIZE>> keys) {
-    int rounds = keys.size();
-    bitset<SIZE> result = data;
-
-    bitset<HALF_SIZE> left, right;
-    for (int i = 0; i < HALF_SIZE; i++) {
-      left[i] = result[i];
-      right[i] = result[i + HALF_SIZE];
-    }
-
-    for (int i = rounds - 1; i >= 0; i--) {
-      bitset<HALF_SIZE> temp = Function(right, keys[i]);
-      for (int j = 0; j < HALF_SIZE; j++) {
-        temp[j] = temp[j] ^ left[j];
-      }
-
-      left = right;
-      right = temp;
-
-      for (int j = 0; j < HALF_SIZE; j++) {
-        result[j] = left[j];
-        result[j + HALF_SIZE] = right[j];
-      }
-    }
-
-    // Final swap
-    for (int j = 0; j < HALF_SIZE; j++) {
-      result[j] = right[j];
-      result[j + HALF_SIZE] = left[j];
-    }
-
-    return result;
-  }
-};
-
 // ------------------ MAIN FUNCTION ------------------
 int main() {
   // Convert input and keys to bitsets
@@ -181,6 +37,39 @@ int main() {
   cout << "\nDecrypted Bitset:   ";
   printBitset(decrypted);
 
+  // 🧩 Same block through the generic network: 16 unrolled ARX rounds
+  Feistel<128, 16, ArxRound>::Keys arxKeys;
+  for (size_t i = 0; i < arxKeys.size(); i++)
+    arxKeys[i] = (i % 2 ? key1 : key0).to_ullong() + i;
+  Feistel<128, 16, ArxRound> arx(arxKeys);
+  uint64_t left, right;
+  bitsetToHalves(data, left, right);
+  arx.encrypt(left, right);
+  cout << "\nARX Feistel (16 rounds) Encrypted:   ";
+  printBitset(halvesToBitset(left, right));
+  arx.decrypt(left, right);
+  cout << "ARX Feistel (16 rounds) Decrypted:   ";
+  printBitset(halvesToBitset(left, right));
+
+  // 📦 Byte buffers of any length: CBC with PKCS#7 padding, then CTR
+  string message = "The Eagle flies over every block boundary, not just the first sixteen characters.";
+  uint8_t iv[16];
+  for (size_t i = 0; i < sizeof(iv); i++)
+    iv[i] = (uint8_t)(0xA0 + i);
+  vector<uint8_t> cbc(arx.paddedSize(message.size())), plain(cbc.size());
+  size_t cbcLen = arx.encryptCBC(iv, (const uint8_t *)message.data(), message.size(), cbc.data());
+  cout << "\nCBC Ciphertext (" << cbcLen << " bytes):   ";
+  for (size_t i = 0; i < cbcLen; i++)
+    cout << std::hex << std::setfill('0') << setw(2) << (int)cbc[i];
+  cout << std::dec << std::setfill(' ') << "\n";
+  size_t plainLen = arx.decryptCBC(iv, cbc.data(), cbcLen, plain.data());
+  cout << "CBC Decrypted:   " << string(plain.begin(), plain.begin() + plainLen) << "\n";
+
+  vector<uint8_t> ctr(message.size());
+  arx.cryptCTR(0xEA61E, (const uint8_t *)message.data(), message.size(), ctr.data());
+  arx.cryptCTR(0xEA61E, ctr.data(), ctr.size(), plain.data());
+  cout << "CTR Decrypted:   " << string(plain.begin(), plain.begin() + ctr.size()) << "\n";
+
   // Just a styled slogan at the end ✨
   string slogan = "<------------------------The Eagle------------------------>";
   cout << "\n"
@@ -0,0 +1,487 @@
+// ------------------ FEISTEL CIPHER CORE ------------------
+// 128-bit block split into 64-bit halves, F(R, K) = R ⊕ K, one round per key.
+// FeistelEngine does the work on two uint64_t halves; FeistelCipher keeps the bitset API on top of it.
+// Feistel<BlockBits, Rounds, RoundFn> is the compile-time version, with ARX and SPN round functions and
+// CBC (PKCS#7) / CTR modes over byte buffers of any length.
+// FeistelCipher.cpp is the demo; include this header to use the cipher elsewhere.
+
+#pragma once
+
+#include "../Common/ThreadPool.hpp"
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Block and half-block width of the bitset API
+constexpr size_t SIZE = 128, HALF_SIZE = SIZE / 2;
+
+// ------------------ CONVERT STRING TO 128-BIT BITSET[FOR KEYS] ------------------
+inline std::bitset<SIZE> stringToBitsetFromChars(const std::string &input) {
+  std::bitset<SIZE> result;
+  size_t totalBits = input.size() * 8;
+  if (SIZE < totalBits)
+    throw std::invalid_argument("Bitset too small for input string!");
+
+  for (size_t i = 0; i < input.size(); ++i) {
+    std::bitset<8> charBits(input[i]);
+    for (size_t b = 0; b < 8; ++b) {
+      result[(input.size() - 1 - i) * 8 + b] = charBits[b];
+    }
+  }
+  return result;
+}
+
+// ------------------ CONVERT STRING TO 64-BIT BITSET[FOR KEYS] ------------------
+
+inline std::bitset<HALF_SIZE> stringToHalfBitsetFromChars(const std::string &input) {
+  std::bitset<HALF_SIZE> result;
+  size_t totalBits = input.size() * 8;
+  if (HALF_SIZE < totalBits)
+    throw std::invalid_argument("Bitset too small for input string!");
+
+  for (size_t i = 0; i < input.size(); ++i) {
+    std::bitset<8> charBits(input[i]);
+    for (size_t b = 0; b < 8; ++b) {
+      result[(input.size() - 1 - i) * 8 + b] = charBits[b];
+    }
+  }
+  return result;
+}
+
+// ------------------ 128-BIT PRINTING FUNCTION ------------------
+inline void printBitset(std::bitset<SIZE> data) {
+  for (size_t i = 0; i < data.size(); ++i) {
+    if (i % 8 == 0)
+      std::cout << " ";
+    std::cout << data[i];
+  }
+  std::cout << std::endl;
+}
+
+// ------------------ 64-BIT PRINTING FUNCTION ------------------
+inline void printHalfBitset(std::bitset<HALF_SIZE> data) {
+  for (size_t i = 0; i < data.size(); ++i) {
+    if (i % 8 == 0)
+      std::cout << " ";
+    std::cout << data[i];
+  }
+  std::cout << std::endl;
+}
+
+// ------------------ ROUND FUNCTIONS ------------------
+// Any callable uint64_t(uint64_t right, uint64_t key) can be a round function. The ones below are templates on
+// the half width so Feistel<BlockBits, Rounds, RoundFn> can size them; their inputs and outputs fit HalfBits bits.
+
+// F(R, K) = R ⊕ K: the original, and linear (every output bit is one input bit), so only good for demos
+template <size_t HalfBits = 64> struct XorRound {
+  uint64_t operator()(uint64_t right, uint64_t key) const { return right ^ key; }
+};
+
+template <size_t HalfBits> constexpr uint64_t halfMask() {
+  return HalfBits >= 64 ? ~uint64_t(0) : (uint64_t(1) << HalfBits) - 1;
+}
+template <size_t HalfBits> constexpr uint64_t rotateLeft(uint64_t x, unsigned n) {
+  // Native widths get a native rotate; anything else shifts and masks
+  if constexpr (HalfBits == 8 || HalfBits == 16 || HalfBits == 32) {
+    using W = std::conditional_t<HalfBits == 8, uint8_t, std::conditional_t<HalfBits == 16, uint16_t, uint32_t>>;
+    W w = (W)x;
+    return (W)((W)(w << n) | (W)(w >> (HalfBits - n)));
+  } else {
+    return ((x << n) | (x >> (HalfBits - n))) & halfMask<HalfBits>();
+  }
+}
+
+// ARX: add, rotate, xor (the ChaCha / Speck toolbox). Carries make the addition non-linear over GF(2),
+// and the rotations (scaled to the half width) spread them across the word.
+template <size_t HalfBits> struct ArxRound {
+  static_assert(HalfBits >= 4 && HalfBits <= 64, "ARX round needs 4..64-bit halves");
+  static constexpr unsigned A = HalfBits * 5 / 16, B = HalfBits * 3 / 8 + 1, C = HalfBits / 8 + 1;
+  uint64_t operator()(uint64_t right, uint64_t key) const {
+    constexpr uint64_t M = halfMask<HalfBits>();
+    uint64_t x = (right + key) & M;
+    x ^= rotateLeft<HalfBits>(x, A);
+    x = (x + rotateLeft<HalfBits>(x ^ key, B)) & M;
+    return x ^ rotateLeft<HalfBits>(x, C);
+  }
+};
+
+// SPN: key XOR, the PRESENT 4-bit S-box on every nibble, then PRESENT's bit permutation generalised to
+// HalfBits (bit i -> i * HalfBits / 4 mod HalfBits - 1, top bit fixed). S-box and permutation are folded
+// into one table per byte (per nibble when HalfBits is not whole bytes) at compile time, T-table style,
+// so a round is HalfBits / 8 lookups and ORs.
+template <size_t HalfBits> struct SpnRound {
+  static_assert(HalfBits >= 8 && HalfBits <= 64 && HalfBits % 4 == 0, "SPN round needs 8..64-bit halves, whole nibbles");
+  static constexpr size_t CHUNK = HalfBits % 8 == 0 ? 8 : 4, CHUNKS = HalfBits / CHUNK;
+
+  uint64_t operator()(uint64_t right, uint64_t key) const { return lookup(right ^ key, std::make_index_sequence<CHUNKS>()); }
+
+private:
+  template <size_t... I> static uint64_t lookup(uint64_t x, std::index_sequence<I...>) {
+    return (TABLE.t[I][(x >> (CHUNK * I)) & ((1u << CHUNK) - 1)] | ...);
+  }
+
+  struct Table {
+    uint64_t t[CHUNKS][1 << CHUNK];
+  };
+  static constexpr Table build() {
+    constexpr uint8_t SBOX[16] = {0xC, 0x5, 0x6, 0xB, 0x9, 0x0, 0xA, 0xD, 0x3, 0xE, 0xF, 0x8, 0x4, 0x7, 0x1, 0x2};
+    Table table{};
+    for (size_t pos = 0; pos < CHUNKS; pos++)
+      for (unsigned v = 0; v < (1u << CHUNK); v++)
+        for (unsigned b = 0; b < CHUNK; b++)
+          if ((SBOX[(v >> (b & ~3u)) & 0xF] >> (b & 3)) & 1) {
+            size_t bit = CHUNK * pos + b;
+            size_t to = bit == HalfBits - 1 ? bit : bit * (HalfBits / 4) % (HalfBits - 1);
+            table.t[pos][v] |= uint64_t(1) << to;
+          }
+    return table;
+  }
+  static constexpr Table TABLE = build();
+};
+
+template <class RoundFn = XorRound<>> class FeistelEngine {
+public:
+  FeistelEngine(const uint64_t *keys, size_t rounds, RoundFn f = RoundFn())
+      : roundKeys(keys, keys + rounds), F(f) {}
+  explicit FeistelEngine(std::vector<uint64_t> keys, RoundFn f = RoundFn())
+      : roundKeys(std::move(keys)), F(f) {}
+
+  size_t rounds() const { return roundKeys.size(); }
+
+  // ------------------ ENCRYPTION FUNCTION ------------------
+  void encrypt(uint64_t &left, uint64_t &right) const {
+    const uint64_t *k = roundKeys.data();
+    uint64_t l = left, r = right;
+    for (size_t i = 0, n = roundKeys.size(); i < n; i++) {
+      uint64_t t = F(r, k[i]) ^ l;
+      l = r;
+      r = t;
+    }
+    // Final swap
+    left = r;
+    right = l;
+  }
+
+  // ------------------ DECRYPTION FUNCTION ------------------
+  void decrypt(uint64_t &left, uint64_t &right) const {
+    const uint64_t *k = roundKeys.data();
+    uint64_t l = left, r = right;
+    for (size_t i = roundKeys.size(); i-- > 0;) {
+      uint64_t t = F(r, k[i]) ^ l;
+      l = r;
+      r = t;
+    }
+    left = r;
+    right = l;
+  }
+
+private:
+  std::vector<uint64_t> roundKeys;
+  RoundFn F;
+};
+
+// ------------------ GENERIC FEISTEL NETWORK ------------------
+// Block width, round count and round function are all template parameters: the rounds unroll at compile time
+// (a fold over an index sequence), F inlines, and nothing is dispatched at runtime. Halves are HalfBits wide,
+// held in uint64_t; for BlockBits <= 64 the block is also available as one integer (left = low half), which is
+// the shape format-preserving uses want (a 20-bit block covers 0 .. 2^20 - 1; cycle-walk to smaller domains).
+//   Feistel<128, 16, ArxRound> arx(keys);   Feistel<32, 12, SpnRound> small(keys);
+template <size_t BlockBits, size_t Rounds, template <size_t> class RoundFn = XorRound> class Feistel {
+  static_assert(BlockBits % 2 == 0 && BlockBits >= 4 && BlockBits <= 128, "Feistel block must be an even 4..128 bits");
+  static_assert(Rounds >= 1, "Feistel needs at least one round");
+
+public:
+  static constexpr size_t BLOCK_BITS = BlockBits, HALF_BITS = BlockBits / 2, ROUNDS = Rounds;
+  static constexpr uint64_t MASK = halfMask<HALF_BITS>();
+  using Keys = std::array<uint64_t, Rounds>;
+  using Round = RoundFn<HALF_BITS>;
+
+  //  Round keys are cut to HALF_BITS
+  explicit Feistel(const Keys &keys, Round f = Round()) : roundKeys(keys), F(f) {
+    for (uint64_t &k : roundKeys)
+      k &= MASK;
+  }
+
+  // ------------------ ENCRYPTION FUNCTION ------------------
+  void encrypt(uint64_t &left, uint64_t &right) const {
+    run(left, right, std::make_index_sequence<Rounds>(), false);
+  }
+  // ------------------ DECRYPTION FUNCTION ------------------
+  void decrypt(uint64_t &left, uint64_t &right) const {
+    run(left, right, std::make_index_sequence<Rounds>(), true);
+  }
+
+  //  Whole block as one integer < 2^BlockBits (BlockBits <= 64)
+  uint64_t encrypt(uint64_t block) const {
+    static_assert(BlockBits <= 64, "use encrypt(left, right) for blocks wider than 64 bits");
+    uint64_t left = block & MASK, right = (block >> (HALF_BITS % 64)) & MASK;
+    encrypt(left, right);
+    return left | right << (HALF_BITS % 64);
+  }
+  uint64_t decrypt(uint64_t block) const {
+    static_assert(BlockBits <= 64, "use decrypt(left, right) for blocks wider than 64 bits");
+    uint64_t left = block & MASK, right = (block >> (HALF_BITS % 64)) & MASK;
+    decrypt(left, right);
+    return left | right << (HALF_BITS % 64);
+  }
+
+  // ------------------ BYTE BLOCKS ------------------
+  // A block is BLOCK_BYTES of memory: the first HALF_BYTES are the left half, the rest the right half, each
+  // half little-endian. Needs whole-byte halves (BlockBits a multiple of 16).
+  static constexpr size_t BLOCK_BYTES = BlockBits / 8, HALF_BYTES = HALF_BITS / 8;
+  //  Blocks run side by side in one thread, and blocks per thread-pool task
+  static constexpr size_t LANES = 4, CHUNK_BLOCKS = 4096;
+
+  static void load(const uint8_t *p, uint64_t &left, uint64_t &right) {
+    left = loadHalf(p);
+    right = loadHalf(p + HALF_BYTES);
+  }
+  static void store(uint8_t *p, uint64_t left, uint64_t right) {
+    storeHalf(p, left);
+    storeHalf(p + HALF_BYTES, right);
+  }
+  void encryptBlock(const uint8_t *in, uint8_t *out) const {
+    uint64_t l, r;
+    load(in, l, r);
+    encrypt(l, r);
+    store(out, l, r);
+  }
+  void decryptBlock(const uint8_t *in, uint8_t *out) const {
+    uint64_t l, r;
+    load(in, l, r);
+    decrypt(l, r);
+    store(out, l, r);
+  }
+
+  //  N independent blocks interleaved round by round. One block's rounds are a serial chain; N chains keep the
+  //  pipeline full, and the lane loop vectorises for the XOR and ARX rounds.
+  template <size_t N> void encryptLanes(uint64_t (&left)[N], uint64_t (&right)[N]) const {
+    runLanes(left, right, std::make_index_sequence<Rounds>(), false);
+  }
+  template <size_t N> void decryptLanes(uint64_t (&left)[N], uint64_t (&right)[N]) const {
+    runLanes(left, right, std::make_index_sequence<Rounds>(), true);
+  }
+
+  // ------------------ CBC MODE (PKCS#7) ------------------
+  //  Padding always adds 1..BLOCK_BYTES bytes, so out needs paddedSize(len)
+  static size_t paddedSize(size_t len) { return (len / BLOCK_BYTES + 1) * BLOCK_BYTES; }
+
+  //  Returns the ciphertext length. Each block chains on the last, so encryption is serial; in may equal out.
+  size_t encryptCBC(const uint8_t iv[BLOCK_BYTES], const uint8_t *in, size_t len, uint8_t *out) const {
+    static_assert(BlockBits % 16 == 0, "byte modes need whole-byte halves");
+    uint64_t cl, cr, l, r;
+    load(iv, cl, cr);
+    size_t full = len / BLOCK_BYTES * BLOCK_BYTES;
+    for (size_t i = 0; i < full; i += BLOCK_BYTES) {
+      load(in + i, l, r);
+      l ^= cl;
+      r ^= cr;
+      encrypt(l, r);
+      store(out + i, l, r);
+      cl = l;
+      cr = r;
+    }
+    uint8_t last[BLOCK_BYTES];
+    size_t rest = len - full;
+    memcpy(last, in + full, rest);
+    memset(last + rest, (int)(BLOCK_BYTES - rest), BLOCK_BYTES - rest);
+    load(last, l, r);
+    l ^= cl;
+    r ^= cr;
+    encrypt(l, r);
+    store(out + full, l, r);
+    return full + BLOCK_BYTES;
+  }
+
+  //  Returns the plaintext length. Blocks decrypt independently, so chunks go over the pool; in may equal out
+  //  (the block before each chunk is saved first). Throws on a bad length or bad padding.
+  size_t decryptCBC(const uint8_t iv[BLOCK_BYTES], const uint8_t *in, size_t len, uint8_t *out,
+                    lab::ThreadPool &pool = lab::defaultPool()) const {
+    static_assert(BlockBits % 16 == 0, "byte modes need whole-byte halves");
+    if (len == 0 || len % BLOCK_BYTES)
+      throw std::invalid_argument("CBC ciphertext must be a non-empty whole number of blocks!");
+    const size_t blocks = len / BLOCK_BYTES, tasks = (blocks + CHUNK_BLOCKS - 1) / CHUNK_BLOCKS;
+    std::vector<uint8_t> chain(tasks * BLOCK_BYTES);
+    for (size_t t = 0; t < tasks; t++)
+      memcpy(&chain[t * BLOCK_BYTES], t ? in + (t * CHUNK_BLOCKS - 1) * BLOCK_BYTES : iv, BLOCK_BYTES);
+
+    pool.parallelFor(tasks, [&](size_t t) {
+      const size_t first = t * CHUNK_BLOCKS, n = std::min(CHUNK_BLOCKS, blocks - first);
+      uint64_t pl, pr;
+      load(&chain[t * BLOCK_BYTES], pl, pr);
+      for (size_t i = 0; i < n; i += LANES) {
+        const size_t m = std::min(LANES, n - i);
+        const uint8_t *src = in + (first + i) * BLOCK_BYTES;
+        uint8_t *dst = out + (first + i) * BLOCK_BYTES;
+        uint64_t cl[LANES] = {}, cr[LANES] = {}, l[LANES], r[LANES];
+        for (size_t j = 0; j < m; j++)
+          load(src + j * BLOCK_BYTES, cl[j], cr[j]);
+        std::copy(cl, cl + LANES, l);
+        std::copy(cr, cr + LANES, r);
+        decryptLanes(l, r);
+        for (size_t j = 0; j < m; j++)
+          store(dst + j * BLOCK_BYTES, l[j] ^ (j ? cl[j - 1] : pl), r[j] ^ (j ? cr[j - 1] : pr));
+        pl = cl[m - 1];
+        pr = cr[m - 1];
+      }
+    });
+
+    // Padding check without an early exit on the first bad byte
+    const uint8_t pad = out[len - 1];
+    uint8_t bad = (uint8_t)(pad == 0) | (uint8_t)(pad > BLOCK_BYTES);
+    for (size_t i = 1; i <= BLOCK_BYTES; i++)
+      bad |= (uint8_t)(i <= pad) & (uint8_t)(out[len - i] != pad);
+    if (bad)
+      throw std::invalid_argument("Bad CBC padding!");
+    return len - pad;
+  }
+
+  // ------------------ CTR MODE ------------------
+  //  Counter block = (nonce, block index): left half the nonce, right half the counter from 0. Any length, no
+  //  padding, same call both ways, and every block is independent. A nonce must never repeat under one key;
+  //  the counter may not wrap, so one message is at most 2^HALF_BITS blocks.
+  void cryptCTR(uint64_t nonce, const uint8_t *in, size_t len, uint8_t *out,
+                lab::ThreadPool &pool = lab::defaultPool()) const {
+    static_assert(BlockBits % 16 == 0, "byte modes need whole-byte halves");
+    const size_t blocks = (len + BLOCK_BYTES - 1) / BLOCK_BYTES;
+    if (HALF_BITS < 64 && blocks > (size_t)MASK + 1)
+      throw std::invalid_argument("CTR message too long for this block size!");
+    nonce &= MASK;
+
+    pool.parallelFor((blocks + CHUNK_BLOCKS - 1) / CHUNK_BLOCKS, [&](size_t t) {
+      const size_t first = t * CHUNK_BLOCKS, n = std::min(CHUNK_BLOCKS, blocks - first);
+      for (size_t i = 0; i < n; i += LANES) {
+        uint64_t l[LANES], r[LANES];
+        for (size_t j = 0; j < LANES; j++) {
+          l[j] = nonce;
+          r[j] = (first + i + j) & MASK;
+        }
+        encryptLanes(l, r);
+        for (size_t j = 0; j < LANES && i + j < n; j++) {
+          const size_t off = (first + i + j) * BLOCK_BYTES;
+          if (off + BLOCK_BYTES <= len) {
+            uint64_t dl, dr;
+            load(in + off, dl, dr);
+            store(out + off, dl ^ l[j], dr ^ r[j]);
+          } else {
+            uint8_t ks[BLOCK_BYTES];
+            store(ks, l[j], r[j]);
+            for (size_t b = 0; off + b < len; b++)
+              out[off + b] = in[off + b] ^ ks[b];
+          }
+        }
+      }
+    });
+  }
+
+private:
+  Keys roundKeys;
+  Round F;
+
+  static uint64_t loadHalf(const uint8_t *p) {
+    uint64_t v = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(&v, p, HALF_BYTES);
+#else
+    for (size_t b = 0; b < HALF_BYTES; b++)
+      v |= (uint64_t)p[b] << (8 * b);
+#endif
+    return v;
+  }
+  static void storeHalf(uint8_t *p, uint64_t v) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(p, &v, HALF_BYTES);
+#else
+    for (size_t b = 0; b < HALF_BYTES; b++)
+      p[b] = (uint8_t)(v >> (8 * b));
+#endif
+  }
+
+  template <size_t N, size_t... I>
+  void runLanes(uint64_t (&left)[N], uint64_t (&right)[N], std::index_sequence<I...>, bool reverse) const {
+    uint64_t l[N], r[N];
+    for (size_t j = 0; j < N; j++) {
+      l[j] = left[j] & MASK;
+      r[j] = right[j] & MASK;
+    }
+    if (reverse)
+      ((stepLanes(l, r, roundKeys[Rounds - 1 - I])), ...);
+    else
+      ((stepLanes(l, r, roundKeys[I])), ...);
+    for (size_t j = 0; j < N; j++) {
+      left[j] = r[j];
+      right[j] = l[j];
+    }
+  }
+  template <size_t N> void stepLanes(uint64_t (&l)[N], uint64_t (&r)[N], uint64_t key) const {
+    for (size_t j = 0; j < N; j++) {
+      uint64_t t = (F(r[j], key) ^ l[j]) & MASK;
+      l[j] = r[j];
+      r[j] = t;
+    }
+  }
+
+  template <size_t... I>
+  void run(uint64_t &left, uint64_t &right, std::index_sequence<I...>, bool reverse) const {
+    uint64_t l = left & MASK, r = right & MASK;
+    if (reverse)
+      ((step(l, r, roundKeys[Rounds - 1 - I])), ...);
+    else
+      ((step(l, r, roundKeys[I])), ...);
+    // Final swap
+    left = r;
+    right = l;
+  }
+  void step(uint64_t &l, uint64_t &r, uint64_t key) const {
+    uint64_t t = (F(r, key) ^ l) & MASK;
+    l = r;
+    r = t;
+  }
+};
+
+// ------------------ BITSET <-> WORDS ------------------
+inline void bitsetToHalves(const std::bitset<SIZE> &data, uint64_t &left, uint64_t &right) {
+  left = (data << HALF_SIZE >> HALF_SIZE).to_ullong();
+  right = (data >> HALF_SIZE).to_ullong();
+}
+inline std::bitset<SIZE> halvesToBitset(uint64_t left, uint64_t right) {
+  return std::bitset<SIZE>(right) << HALF_SIZE | std::bitset<SIZE>(left);
+}
+
+// ------------------ BITSET API (ADAPTER) ------------------
+// The original interface: converts block and keys to words and runs FeistelEngine<XorRound>.
+class FeistelCipher {
+private:
+  static std::vector<uint64_t> toWords(const std::vector<std::bitset<HALF_SIZE>> &keys) {
+    std::vector<uint64_t> words(keys.size());
+    for (size_t i = 0; i < keys.size(); i++)
+      words[i] = keys[i].to_ullong();
+    return words;
+  }
+
+public:
+  // ------------------ ENCRYPTION FUNCTION ------------------
+  std::bitset<SIZE> encrypt(std::bitset<SIZE> data, std::vector<std::bitset<HALF_SIZE>> keys) {
+    uint64_t left, right;
+    bitsetToHalves(data, left, right);
+    FeistelEngine<>(toWords(keys)).encrypt(left, right);
+    return halvesToBitset(left, right);
+  }
+
+  // ------------------ DECRYPTION FUNCTION ------------------
+  std::bitset<SIZE> decrypt(std::bitset<SIZE> data, std::vector<std::bitset<HALF_SIZE>> keys) {
+    uint64_t left, right;
+    bitsetToHalves(data, left, right);
+    FeistelEngine<>(toWords(keys)).decrypt(left, right);
+    return halvesToBitset(left, right);
+  }
+};